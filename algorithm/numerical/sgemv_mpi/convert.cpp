@@ -0,0 +1,28 @@
+/* Written by : Eric Tan
+ *
+ * Converts a text matrix (m n followed by the elements) into the binary format read by the
+ * *_binary readers in matrix.cpp. Binary files are picked up by the sgemv program when their name
+ * ends in .bin.
+ */
+
+#include <iostream>
+#include <cstdlib>
+
+#include "matrix.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "Error: Expected 2 inputs.\n" << argv[0] << " text_matrix binary_matrix\n";
+        exit(EXIT_FAILURE);
+    } // Check for correct number of inputs
+
+    if (convert_matrix_to_binary(argv[1], argv[2])) {
+        std::cerr << "Error: Could not convert " << argv[1] << " to " << argv[2] << '\n';
+        exit(EXIT_FAILURE);
+    } // Check conversion
+}
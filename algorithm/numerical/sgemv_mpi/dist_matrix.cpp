@@ -0,0 +1,236 @@
+#include <algorithm>
+
+#include "dist_matrix.h"
+#include "mpi_utility.h"
+#include "kernel.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * CONSTRUCTOR / DESTRUCTOR
+ *-----------------------------------------------------------------------------------------------*/
+
+/* DistMatrix::DistMatrix() constructor
+ *
+ * @param: filename = input filename (text, or binary if it ends in .bin)
+ * @param: d = DistMatrix::ROW or DistMatrix::COL
+ * @param: c = MPI communicator
+ *
+ * Reads and decomposes the matrix, then builds the communication plan used by every multiply.
+ */
+DistMatrix::DistMatrix(const std::string &filename, Decomposition d, MPI_Comm c) : decomp(d)
+{
+    float *mat;
+
+    MPI_Comm_dup(c, &comm);
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &id);
+
+    if (decomp == ROW) {
+        mat_dim = read_row_matrix(filename, &mat, comm);
+        A.reset(mat);
+        make_row_plan();
+    } else {
+        mat_dim = read_col_matrix(filename, &mat, comm);
+        A.reset(mat);
+        make_col_plan();
+    } // Read and plan for the decomposition
+}
+
+
+/* DistMatrix::~DistMatrix() destructor
+ *
+ * Frees the persistent requests and the duplicated communicator. Must run before MPI_Finalize().
+ */
+DistMatrix::~DistMatrix()
+{
+    for (auto &req : requests)
+        MPI_Request_free(&req);
+
+    MPI_Comm_free(&comm);
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * COMMUNICATION PLANS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* DistMatrix::make_row_plan()
+ *
+ * Plan for replicating b. Each proc copies its block of b into recv_buf, then the requests
+ * fill in every other block. Uses one persistent MPI_Allgatherv on MPI 4, or a persistent send
+ * and receive per pair of procs before that.
+ */
+void DistMatrix::make_row_plan()
+{
+    make_mixed_xfer_array(p, mat_dim.second, cnt_in, disp_in);
+    recv_buf.resize(mat_dim.second);
+
+#if MPI_VERSION >= 4
+    requests.resize(1);
+    MPI_Allgatherv_init(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, recv_buf.data(), cnt_in.data(),
+            disp_in.data(), MPI_FLOAT, comm, MPI_INFO_NULL, &requests[0]);
+#else
+    for (int i = 0; i < p; i++) {
+        if (i == id)
+            continue;
+
+        MPI_Request req;
+        if (cnt_in[i]) {
+            MPI_Recv_init(recv_buf.data() + disp_in[i], cnt_in[i], MPI_FLOAT, i, DATA_MSG, comm,
+                    &req);
+            requests.push_back(req);
+        } // Receive proc i's block
+
+        if (cnt_in[id]) {
+            MPI_Send_init(recv_buf.data() + disp_in[id], cnt_in[id], MPI_FLOAT, i, DATA_MSG,
+                    comm, &req);
+            requests.push_back(req);
+        } // Send this proc's block to proc i
+    } // Loop over procs
+#endif
+}
+
+
+/* DistMatrix::make_col_plan()
+ *
+ * Plan for summing the partial results. send_buf holds this proc's partial c and recv_buf gets
+ * every proc's partial block of c. Uses one persistent MPI_Alltoallv on MPI 4, or a persistent
+ * send and receive per pair of procs before that.
+ */
+void DistMatrix::make_col_plan()
+{
+    make_mixed_xfer_array(p, mat_dim.first, cnt_out, disp_out);
+    make_uniform_xfer_array(id, p, mat_dim.first, cnt_in, disp_in);
+    send_buf.resize(mat_dim.first);
+    recv_buf.resize(p * block_size(id, p, mat_dim.first));
+
+#if MPI_VERSION >= 4
+    requests.resize(1);
+    MPI_Alltoallv_init(send_buf.data(), cnt_out.data(), disp_out.data(), MPI_FLOAT,
+            recv_buf.data(), cnt_in.data(), disp_in.data(), MPI_FLOAT, comm, MPI_INFO_NULL,
+            &requests[0]);
+#else
+    for (int i = 0; i < p; i++) {
+        if (i == id)
+            continue;
+
+        MPI_Request req;
+        if (cnt_in[i]) {
+            MPI_Recv_init(recv_buf.data() + disp_in[i], cnt_in[i], MPI_FLOAT, i, DATA_MSG, comm,
+                    &req);
+            requests.push_back(req);
+        } // Receive proc i's partial block
+
+        if (cnt_out[i]) {
+            MPI_Send_init(send_buf.data() + disp_out[i], cnt_out[i], MPI_FLOAT, i, DATA_MSG,
+                    comm, &req);
+            requests.push_back(req);
+        } // Send proc i its partial block
+    } // Loop over procs
+#endif
+}
+
+
+/* DistMatrix::start_plan()
+ *
+ * Starts every persistent request. A single proc has none.
+ */
+void DistMatrix::start_plan()
+{
+    if (!requests.empty())
+        MPI_Startall(requests.size(), requests.data());
+}
+
+
+/* DistMatrix::wait_plan()
+ *
+ * Waits for every persistent request to finish. The requests stay allocated for the next call.
+ */
+void DistMatrix::wait_plan()
+{
+    if (!requests.empty())
+        MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+}
+
+/*-------------------------------------------------------------------------------------------------
+ * SGEMV
+ *-----------------------------------------------------------------------------------------------*/
+
+/* DistMatrix::multiply()
+ *
+ * @param: b = block vector with as many elements as A has cols
+ * @param: c = block vector with as many elements as A has rows
+ *
+ * @return: c = A * b
+ *
+ * Runs the plan built by the constructor, so nothing is allocated and no counts are rebuilt.
+ * Aborts if the dimensions do not match.
+ */
+void DistMatrix::multiply(const DistVector &b, DistVector &c)
+{
+    if (b.size() != mat_dim.second || c.size() != mat_dim.first)
+        MPI_Abort(comm, DIM_MISMATCH_ERROR);
+
+    int local_rows = block_size(id, p, mat_dim.first);
+
+    if (decomp == ROW) {
+        std::copy(b.data(), b.data() + b.local_size(), recv_buf.begin() + disp_in[id]);
+
+        start_plan();
+        wait_plan();
+
+        sgemv_row_kernel(A.get(), recv_buf.data(), c.data(), local_rows, mat_dim.second,
+                mat_dim.second);
+    } else {
+        sgemv_col_kernel(A.get(), b.data(), send_buf.data(), mat_dim.first, b.local_size(),
+                mat_dim.first);
+
+        start_plan();
+#if MPI_VERSION < 4
+        std::copy(send_buf.begin() + disp_out[id], send_buf.begin() + disp_out[id] + local_rows,
+                recv_buf.begin() + disp_in[id]);
+#endif
+        wait_plan();
+
+        float *c_blk = c.data();
+        for (int i = 0; i < local_rows; i++) {
+            c_blk[i] = 0.0;
+            for (int j = 0; j < p; j++)
+                c_blk[i] += recv_buf[i + (j * local_rows)];
+        } // Loop over elements in c
+    } // Multiply for the decomposition
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * DATA ACCESS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* DistMatrix::data()
+ *
+ * @return: proc's part of the matrix. Row major for ROW, col major for COL.
+ */
+const float* DistMatrix::data() const noexcept
+{
+    return A.get();
+}
+
+
+/* DistMatrix::dim()
+ *
+ * @return: dimension of the whole matrix
+ */
+dim2 DistMatrix::dim() const noexcept
+{
+    return mat_dim;
+}
+
+
+/* DistMatrix::decomposition()
+ *
+ * @return: how the matrix is split among procs
+ */
+DistMatrix::Decomposition DistMatrix::decomposition() const noexcept
+{
+    return decomp;
+}
@@ -0,0 +1,58 @@
+/* Written by : Eric Tan
+ *
+ * RAII distributed matrix for repeated SGEMV. The matrix owns its decomposition and builds its
+ * communication plan once, as persistent requests, so every multiply only starts and waits on
+ * them.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mpi.h>
+
+#include "matrix.h"
+#include "dist_vector.h"
+
+
+/* class: DistMatrix
+ *
+ * Row or col striped matrix. multiply() computes c = A * b for block vectors b and c.
+ */
+class DistMatrix
+{
+    public:
+        enum Decomposition { ROW, COL };
+
+        // Constructor / destructor / assignment
+        DistMatrix(const std::string &filename, Decomposition d, MPI_Comm c);
+        ~DistMatrix();
+        DistMatrix(const DistMatrix &other) = delete;
+        DistMatrix& operator=(const DistMatrix &rhs) = delete;
+
+        // SGEMV
+        void multiply(const DistVector &b, DistVector &c);
+
+        // Data access
+        const float* data() const noexcept;
+        dim2 dim() const noexcept;
+        Decomposition decomposition() const noexcept;
+
+    private:
+        void make_row_plan();
+        void make_col_plan();
+        void start_plan();
+        void wait_plan();
+
+        MPI_Comm comm; // Duplicate of the user's communicator, so plan messages stay separate
+        Decomposition decomp;
+        dim2 mat_dim;
+        int p, id;
+        std::unique_ptr<float[]> A;
+
+        // Communication plan
+        std::vector<int> cnt_out, disp_out, cnt_in, disp_in;
+        std::vector<float> send_buf, recv_buf;
+        std::vector<MPI_Request> requests;
+};
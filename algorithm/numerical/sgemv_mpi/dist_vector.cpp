@@ -0,0 +1,115 @@
+#include "dist_vector.h"
+#include "vector.h"
+#include "mpi_utility.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * CONSTRUCTORS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* DistVector::DistVector() constructor
+ *
+ * @param: global_n = size of the vector
+ * @param: c = MPI communicator
+ *
+ * Constructs a block vector of n zeros.
+ */
+DistVector::DistVector(int global_n, MPI_Comm c) : comm(c), n(global_n)
+{
+    int id, p;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &id);
+
+    local_n = block_size(id, p, n);
+    v.reset(new float[local_n]());
+}
+
+
+/* DistVector::DistVector() constructor
+ *
+ * @param: filename = file to open
+ * @param: c = MPI communicator
+ *
+ * Reads a block vector with read_block_vector().
+ */
+DistVector::DistVector(const std::string &filename, MPI_Comm c) : comm(c)
+{
+    int id, p;
+    float *block;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &id);
+
+    n = read_block_vector(filename, &block, comm);
+    local_n = block_size(id, p, n);
+    v.reset(block);
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * DATA ACCESS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* DistVector::data()
+ *
+ * @return: pointer to the proc's block
+ */
+float* DistVector::data() noexcept
+{
+    return v.get();
+}
+
+
+/* DistVector::data()
+ *
+ * @return: const pointer to the proc's block
+ */
+const float* DistVector::data() const noexcept
+{
+    return v.get();
+}
+
+
+/* DistVector::size()
+ *
+ * @return: size of the whole vector
+ */
+int DistVector::size() const noexcept
+{
+    return n;
+}
+
+
+/* DistVector::local_size()
+ *
+ * @return: size of the proc's block
+ */
+int DistVector::local_size() const noexcept
+{
+    return local_n;
+}
+
+
+/* DistVector::get_comm()
+ *
+ * @return: communicator the vector is split over
+ */
+MPI_Comm DistVector::get_comm() const noexcept
+{
+    return comm;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * OUTPUT
+ *-----------------------------------------------------------------------------------------------*/
+
+/* DistVector::print()
+ *
+ * Prints the vector with print_block_vector().
+ */
+void DistVector::print() const
+{
+    print_block_vector(v.get(), n, comm);
+}
@@ -0,0 +1,43 @@
+/* Written by : Eric Tan
+ *
+ * RAII block vector. Owns its block of the vector and knows how the vector is split among the
+ * procs of its communicator.
+ */
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mpi.h>
+
+
+/* class: DistVector
+ *
+ * Vector of n floats split into blocks among the procs of comm. Proc id holds elements
+ * [block_low(id, p, n), block_high(id, p, n)].
+ */
+class DistVector
+{
+    public:
+        // Constructor / assignment
+        DistVector(int global_n, MPI_Comm c);
+        DistVector(const std::string &filename, MPI_Comm c);
+        DistVector(const DistVector &other) = delete;
+        DistVector& operator=(const DistVector &rhs) = delete;
+
+        // Data access
+        float* data() noexcept;
+        const float* data() const noexcept;
+        int size() const noexcept;
+        int local_size() const noexcept;
+        MPI_Comm get_comm() const noexcept;
+
+        // Output
+        void print() const;
+
+    private:
+        MPI_Comm comm;
+        int n;
+        int local_n;
+        std::unique_ptr<float[]> v;
+};
@@ -0,0 +1,671 @@
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SGEMV_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#include "kernel.h"
+
+
+/* CONSTANTS
+ */
+constexpr int KERNEL_ROWS = 4;      // Rows per pass of the row major and batched kernels
+constexpr int KERNEL_X_TILE = 2048; // Elements of x (or X) kept in cache by those kernels
+
+// The SIMD row kernels keep one accumulator per row in named registers
+static_assert(KERNEL_ROWS == 4, "row_kernel_avx2() and row_kernel_avx512() unroll 4 rows");
+
+
+/*-------------------------------------------------------------------------------------------------
+ * SCALAR KERNELS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* row_kernel_scalar()
+ *
+ * @param: A = row major m x n matrix
+ * @param: x = input vector of n elements
+ * @param: y = output vector of m elements
+ * @param: m = number of rows
+ * @param: n = number of cols
+ * @param: lda = distance between rows of A
+ *
+ * Computes y = A * x. Used when the CPU has no AVX2.
+ */
+static void row_kernel_scalar(const float *A, const float *x, float *y, int m, int n,
+        std::ptrdiff_t lda)
+{
+    int i = 0;
+
+    for (; i + KERNEL_ROWS <= m; i += KERNEL_ROWS) {
+        float sum[KERNEL_ROWS] = {0.0};
+
+        for (int j = 0; j < n; j++)
+            for (int k = 0; k < KERNEL_ROWS; k++)
+                sum[k] += A[(i + k) * lda + j] * x[j];
+
+        for (int k = 0; k < KERNEL_ROWS; k++)
+            y[i + k] = sum[k];
+    } // Loop over groups of rows
+
+    for (; i < m; i++) {
+        float sum = 0.0;
+        for (int j = 0; j < n; j++)
+            sum += A[i * lda + j] * x[j];
+        y[i] = sum;
+    } // Loop over remaining rows
+}
+
+
+/* col_kernel_scalar()
+ *
+ * @param: A = col major m x n matrix
+ * @param: x = input vector of n elements
+ * @param: y = output vector of m elements
+ * @param: m = number of rows
+ * @param: n = number of cols
+ * @param: lda = distance between cols of A
+ *
+ * Computes y = A * x by adding up the cols of A scaled by x. Used when the CPU has no AVX2.
+ */
+static void col_kernel_scalar(const float *A, const float *x, float *y, int m, int n,
+        std::ptrdiff_t lda)
+{
+    std::fill(y, y + m, 0.0f);
+
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < m; i++)
+            y[i] += A[j * lda + i] * x[j];
+}
+
+
+/* batch_kernel_scalar()
+ *
+ * @param: A = m x n matrix. Element (i, j) is A[i * rs + j * cs]
+ * @param: X = row major n x k block of vectors
+ * @param: Y = row major m x k block of output vectors
+ * @param: m = number of rows
+ * @param: n = number of cols
+ * @param: k = number of vectors
+ * @param: rs, cs = distance between rows and cols of A
+ *
+ * Computes Y = A * X, reading every element of A once for all k vectors. Used when the CPU has no
+ * AVX2.
+ */
+static void batch_kernel_scalar(const float *A, const float *X, float *Y, int m, int n,
+        std::ptrdiff_t k, std::ptrdiff_t rs, std::ptrdiff_t cs)
+{
+    std::fill(Y, Y + m * k, 0.0f);
+
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            float a = A[i * rs + j * cs];
+            for (int v = 0; v < k; v++)
+                Y[i * k + v] += a * X[j * k + v];
+        } // Loop over cols
+    } // Loop over rows
+}
+
+
+#ifdef SGEMV_X86_KERNELS
+/*-------------------------------------------------------------------------------------------------
+ * AVX2 KERNELS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* hsum_avx2()
+ *
+ * @param: v = vector to sum
+ *
+ * @return: sum of the 8 elements of v
+ */
+__attribute__((target("avx2,fma")))
+static inline float hsum_avx2(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+
+    return _mm_cvtss_f32(s);
+}
+
+
+/* row_kernel_avx2()
+ *
+ * Same as row_kernel_scalar(). x is split into tiles of KERNEL_X_TILE elements that stay in
+ * cache while every row is run against them. Each pass keeps KERNEL_ROWS rows in registers and
+ * shares every load of x between them.
+ */
+__attribute__((target("avx2,fma")))
+static void row_kernel_avx2(const float *A, const float *x, float *y, int m, int n,
+        std::ptrdiff_t lda)
+{
+    std::fill(y, y + m, 0.0f);
+
+    for (int jb = 0; jb < n; jb += KERNEL_X_TILE) {
+        int nb = std::min(KERNEL_X_TILE, n - jb);
+        int nv = nb - nb % 8;
+        const float *xb = x + jb;
+        int i = 0;
+
+        for (; i + KERNEL_ROWS <= m; i += KERNEL_ROWS) {
+            const float *a0 = A + i * lda + jb;
+            const float *a1 = a0 + lda;
+            const float *a2 = a1 + lda;
+            const float *a3 = a2 + lda;
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            __m256 acc2 = _mm256_setzero_ps();
+            __m256 acc3 = _mm256_setzero_ps();
+
+            for (int j = 0; j < nv; j += 8) {
+                __m256 xv = _mm256_loadu_ps(xb + j);
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j), xv, acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j), xv, acc1);
+                acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j), xv, acc2);
+                acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j), xv, acc3);
+            } // Loop over vectors in tile
+
+            float s0 = hsum_avx2(acc0), s1 = hsum_avx2(acc1);
+            float s2 = hsum_avx2(acc2), s3 = hsum_avx2(acc3);
+            for (int j = nv; j < nb; j++) {
+                s0 += a0[j] * xb[j];
+                s1 += a1[j] * xb[j];
+                s2 += a2[j] * xb[j];
+                s3 += a3[j] * xb[j];
+            } // Loop over remaining cols
+
+            y[i] += s0;
+            y[i + 1] += s1;
+            y[i + 2] += s2;
+            y[i + 3] += s3;
+        } // Loop over groups of rows
+
+        for (; i < m; i++) {
+            const float *a = A + i * lda + jb;
+            __m256 acc = _mm256_setzero_ps();
+
+            for (int j = 0; j < nv; j += 8)
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(xb + j), acc);
+
+            float s = hsum_avx2(acc);
+            for (int j = nv; j < nb; j++)
+                s += a[j] * xb[j];
+            y[i] += s;
+        } // Loop over remaining rows
+    } // Loop over tiles of x
+}
+
+
+/* col_kernel_avx2()
+ *
+ * Same as col_kernel_scalar(). Keeps 32 elements of y in registers while every col is added in,
+ * so y is only written once.
+ */
+__attribute__((target("avx2,fma")))
+static void col_kernel_avx2(const float *A, const float *x, float *y, int m, int n,
+        std::ptrdiff_t lda)
+{
+    int i = 0;
+
+    for (; i + 32 <= m; i += 32) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+
+        for (int j = 0; j < n; j++) {
+            const float *a = A + j * lda + i;
+            __m256 xv = _mm256_broadcast_ss(x + j);
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a), xv, acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + 8), xv, acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + 16), xv, acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + 24), xv, acc3);
+        } // Loop over cols
+
+        _mm256_storeu_ps(y + i, acc0);
+        _mm256_storeu_ps(y + i + 8, acc1);
+        _mm256_storeu_ps(y + i + 16, acc2);
+        _mm256_storeu_ps(y + i + 24, acc3);
+    } // Loop over groups of 32 rows
+
+    for (; i + 8 <= m; i += 8) {
+        __m256 acc = _mm256_setzero_ps();
+
+        for (int j = 0; j < n; j++)
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(A + j * lda + i), _mm256_broadcast_ss(x + j),
+                    acc);
+
+        _mm256_storeu_ps(y + i, acc);
+    } // Loop over groups of 8 rows
+
+    if (i < m)
+        col_kernel_scalar(A + i, x, y + i, m - i, n, lda);
+}
+
+
+/* lane_mask_avx2()
+ *
+ * @param: w = number of lanes to use
+ *
+ * @return: mask for _mm256_maskload_ps selecting the first w lanes (none if w <= 0)
+ */
+__attribute__((target("avx2,fma")))
+static inline __m256i lane_mask_avx2(int w)
+{
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(w), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+
+/* batch_rows_avx2()
+ *
+ * @param: R = number of rows
+ *
+ * Adds R rows of A times a tile of X into Y. The R x 16 block of Y stays in registers while the
+ * cols of A are broadcast against it, so every element of A is read once per 16 vectors.
+ */
+template <int R>
+__attribute__((target("avx2,fma")))
+static void batch_rows_avx2(const float *A, const float *X, float *Y, int n,
+        std::ptrdiff_t k, std::ptrdiff_t rs, std::ptrdiff_t cs)
+{
+    for (int v = 0; v < k; v += 16) {
+        __m256i mask0 = lane_mask_avx2(k - v);
+        __m256i mask1 = lane_mask_avx2(k - v - 8);
+        __m256 acc[R][2];
+
+        for (int r = 0; r < R; r++) {
+            acc[r][0] = _mm256_maskload_ps(Y + r * k + v, mask0);
+            acc[r][1] = _mm256_maskload_ps(Y + r * k + v + 8, mask1);
+        } // Load block of Y
+
+        for (int j = 0; j < n; j++) {
+            __m256 x0 = _mm256_maskload_ps(X + j * k + v, mask0);
+            __m256 x1 = _mm256_maskload_ps(X + j * k + v + 8, mask1);
+
+            for (int r = 0; r < R; r++) {
+                __m256 a = _mm256_broadcast_ss(A + r * rs + j * cs);
+                acc[r][0] = _mm256_fmadd_ps(a, x0, acc[r][0]);
+                acc[r][1] = _mm256_fmadd_ps(a, x1, acc[r][1]);
+            } // Loop over rows
+        } // Loop over cols
+
+        for (int r = 0; r < R; r++) {
+            _mm256_maskstore_ps(Y + r * k + v, mask0, acc[r][0]);
+            _mm256_maskstore_ps(Y + r * k + v + 8, mask1, acc[r][1]);
+        } // Store block of Y
+    } // Loop over tiles of 16 vectors
+}
+
+
+/* batch_kernel_avx2()
+ *
+ * Same as batch_kernel_scalar(). X is split into tiles of about KERNEL_X_TILE elements that stay
+ * in cache while every group of KERNEL_ROWS rows is run against them.
+ */
+__attribute__((target("avx2,fma")))
+static void batch_kernel_avx2(const float *A, const float *X, float *Y, int m, int n,
+        std::ptrdiff_t k, std::ptrdiff_t rs, std::ptrdiff_t cs)
+{
+    int tile = std::max<std::ptrdiff_t>(16, KERNEL_X_TILE / std::max<std::ptrdiff_t>(k, 1));
+
+    std::fill(Y, Y + m * k, 0.0f);
+
+    for (int jb = 0; jb < n; jb += tile) {
+        int nb = std::min(tile, n - jb);
+        int i = 0;
+
+        for (; i + KERNEL_ROWS <= m; i += KERNEL_ROWS)
+            batch_rows_avx2<KERNEL_ROWS>(A + i * rs + jb * cs, X + jb * k, Y + i * k, nb, k, rs,
+                    cs);
+
+        for (; i < m; i++)
+            batch_rows_avx2<1>(A + i * rs + jb * cs, X + jb * k, Y + i * k, nb, k, rs, cs);
+    } // Loop over tiles of X
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * AVX-512 KERNELS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* hsum_avx512()
+ *
+ * @param: v = vector to sum
+ *
+ * @return: sum of the 16 elements of v
+ *
+ * Folds v in half four times. Uses the zero masked shuffles, since _mm512_reduce_add_ps and the
+ * unmasked shuffles trip -Wmaybe-uninitialized inside GCC's own headers.
+ */
+__attribute__((target("avx512f")))
+static inline float hsum_avx512(__m512 v)
+{
+    const __mmask16 all = 0xFFFF;
+
+    v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(all, v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(all, v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm512_add_ps(v, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm512_add_ps(v, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm512_cvtss_f32(v);
+}
+
+
+/* row_kernel_avx512()
+ *
+ * Same as row_kernel_avx2() with 16 wide vectors. The end of every row is handled with a masked
+ * load instead of scalar code.
+ */
+__attribute__((target("avx512f")))
+static void row_kernel_avx512(const float *A, const float *x, float *y, int m, int n,
+        std::ptrdiff_t lda)
+{
+    std::fill(y, y + m, 0.0f);
+
+    for (int jb = 0; jb < n; jb += KERNEL_X_TILE) {
+        int nb = std::min(KERNEL_X_TILE, n - jb);
+        int nv = nb - nb % 16;
+        __mmask16 tail = static_cast<__mmask16>((1u << (nb - nv)) - 1);
+        const float *xb = x + jb;
+        __m512 x_tail = _mm512_maskz_loadu_ps(tail, xb + nv);
+        int i = 0;
+
+        for (; i + KERNEL_ROWS <= m; i += KERNEL_ROWS) {
+            const float *a0 = A + i * lda + jb;
+            const float *a1 = a0 + lda;
+            const float *a2 = a1 + lda;
+            const float *a3 = a2 + lda;
+            __m512 acc0 = _mm512_setzero_ps();
+            __m512 acc1 = _mm512_setzero_ps();
+            __m512 acc2 = _mm512_setzero_ps();
+            __m512 acc3 = _mm512_setzero_ps();
+
+            for (int j = 0; j < nv; j += 16) {
+                __m512 xv = _mm512_loadu_ps(xb + j);
+                acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a0 + j), xv, acc0);
+                acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a1 + j), xv, acc1);
+                acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a2 + j), xv, acc2);
+                acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a3 + j), xv, acc3);
+            } // Loop over vectors in tile
+
+            acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a0 + nv), x_tail, acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a1 + nv), x_tail, acc1);
+            acc2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a2 + nv), x_tail, acc2);
+            acc3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a3 + nv), x_tail, acc3);
+
+            y[i] += hsum_avx512(acc0);
+            y[i + 1] += hsum_avx512(acc1);
+            y[i + 2] += hsum_avx512(acc2);
+            y[i + 3] += hsum_avx512(acc3);
+        } // Loop over groups of rows
+
+        for (; i < m; i++) {
+            const float *a = A + i * lda + jb;
+            __m512 acc = _mm512_setzero_ps();
+
+            for (int j = 0; j < nv; j += 16)
+                acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + j), _mm512_loadu_ps(xb + j), acc);
+
+            acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a + nv), x_tail, acc);
+            y[i] += hsum_avx512(acc);
+        } // Loop over remaining rows
+    } // Loop over tiles of x
+}
+
+
+/* col_kernel_avx512()
+ *
+ * Same as col_kernel_avx2() with 64 elements of y in registers. The last rows use masked loads
+ * and stores.
+ */
+__attribute__((target("avx512f")))
+static void col_kernel_avx512(const float *A, const float *x, float *y, int m, int n,
+        std::ptrdiff_t lda)
+{
+    int i = 0;
+
+    for (; i + 64 <= m; i += 64) {
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+
+        for (int j = 0; j < n; j++) {
+            const float *a = A + j * lda + i;
+            __m512 xv = _mm512_set1_ps(x[j]);
+            acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a), xv, acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + 16), xv, acc1);
+            acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + 32), xv, acc2);
+            acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + 48), xv, acc3);
+        } // Loop over cols
+
+        _mm512_storeu_ps(y + i, acc0);
+        _mm512_storeu_ps(y + i + 16, acc1);
+        _mm512_storeu_ps(y + i + 32, acc2);
+        _mm512_storeu_ps(y + i + 48, acc3);
+    } // Loop over groups of 64 rows
+
+    for (; i < m; i += 16) {
+        int rows = std::min(16, m - i);
+        __mmask16 mask = static_cast<__mmask16>((1u << rows) - 1);
+        __m512 acc = _mm512_setzero_ps();
+
+        for (int j = 0; j < n; j++)
+            acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, A + j * lda + i),
+                    _mm512_set1_ps(x[j]), acc);
+
+        _mm512_mask_storeu_ps(y + i, mask, acc);
+    } // Loop over groups of 16 rows
+}
+
+
+/* lane_mask_avx512()
+ *
+ * @param: w = number of lanes to use
+ *
+ * @return: mask selecting the first w lanes (none if w <= 0)
+ */
+static inline __mmask16 lane_mask_avx512(int w)
+{
+    if (w <= 0)
+        return 0;
+
+    return w >= 16 ? 0xFFFF : static_cast<__mmask16>((1u << w) - 1);
+}
+
+
+/* batch_rows_avx512()
+ *
+ * Same as batch_rows_avx2() with an R x 32 block of Y in registers.
+ */
+template <int R>
+__attribute__((target("avx512f")))
+static void batch_rows_avx512(const float *A, const float *X, float *Y, int n,
+        std::ptrdiff_t k, std::ptrdiff_t rs, std::ptrdiff_t cs)
+{
+    for (int v = 0; v < k; v += 32) {
+        __mmask16 mask0 = lane_mask_avx512(k - v);
+        __mmask16 mask1 = lane_mask_avx512(k - v - 16);
+        __m512 acc[R][2];
+
+        for (int r = 0; r < R; r++) {
+            acc[r][0] = _mm512_maskz_loadu_ps(mask0, Y + r * k + v);
+            acc[r][1] = _mm512_maskz_loadu_ps(mask1, Y + r * k + v + 16);
+        } // Load block of Y
+
+        for (int j = 0; j < n; j++) {
+            __m512 x0 = _mm512_maskz_loadu_ps(mask0, X + j * k + v);
+            __m512 x1 = _mm512_maskz_loadu_ps(mask1, X + j * k + v + 16);
+
+            for (int r = 0; r < R; r++) {
+                __m512 a = _mm512_set1_ps(A[r * rs + j * cs]);
+                acc[r][0] = _mm512_fmadd_ps(a, x0, acc[r][0]);
+                acc[r][1] = _mm512_fmadd_ps(a, x1, acc[r][1]);
+            } // Loop over rows
+        } // Loop over cols
+
+        for (int r = 0; r < R; r++) {
+            _mm512_mask_storeu_ps(Y + r * k + v, mask0, acc[r][0]);
+            _mm512_mask_storeu_ps(Y + r * k + v + 16, mask1, acc[r][1]);
+        } // Store block of Y
+    } // Loop over tiles of 32 vectors
+}
+
+
+/* batch_kernel_avx512()
+ *
+ * Same as batch_kernel_avx2() with batch_rows_avx512().
+ */
+__attribute__((target("avx512f")))
+static void batch_kernel_avx512(const float *A, const float *X, float *Y, int m, int n,
+        std::ptrdiff_t k, std::ptrdiff_t rs, std::ptrdiff_t cs)
+{
+    int tile = std::max<std::ptrdiff_t>(16, KERNEL_X_TILE / std::max<std::ptrdiff_t>(k, 1));
+
+    std::fill(Y, Y + m * k, 0.0f);
+
+    for (int jb = 0; jb < n; jb += tile) {
+        int nb = std::min(tile, n - jb);
+        int i = 0;
+
+        for (; i + KERNEL_ROWS <= m; i += KERNEL_ROWS)
+            batch_rows_avx512<KERNEL_ROWS>(A + i * rs + jb * cs, X + jb * k, Y + i * k, nb, k, rs,
+                    cs);
+
+        for (; i < m; i++)
+            batch_rows_avx512<1>(A + i * rs + jb * cs, X + jb * k, Y + i * k, nb, k, rs, cs);
+    } // Loop over tiles of X
+}
+#endif
+
+
+/*-------------------------------------------------------------------------------------------------
+ * DISPATCH
+ *-----------------------------------------------------------------------------------------------*/
+
+typedef void (*kernel_fn)(const float*, const float*, float*, int, int, std::ptrdiff_t);
+typedef void (*batch_fn)(const float*, const float*, float*, int, int, std::ptrdiff_t,
+        std::ptrdiff_t, std::ptrdiff_t);
+
+/* struct: kernel_table
+ *
+ * Kernels picked for this CPU.
+ */
+struct kernel_table
+{
+    kernel_fn row;
+    kernel_fn col;
+    batch_fn batch;
+};
+
+
+/* select_kernels()
+ *
+ * @return: fastest kernels the CPU supports
+ */
+static kernel_table select_kernels()
+{
+#ifdef SGEMV_X86_KERNELS
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        return kernel_table{row_kernel_avx512, col_kernel_avx512, batch_kernel_avx512};
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return kernel_table{row_kernel_avx2, col_kernel_avx2, batch_kernel_avx2};
+#endif
+
+    return kernel_table{row_kernel_scalar, col_kernel_scalar, batch_kernel_scalar};
+}
+
+
+/* kernels()
+ *
+ * @return: kernels for this CPU. Selected on the first call.
+ */
+static const kernel_table &kernels()
+{
+    static const kernel_table table = select_kernels();
+    return table;
+}
+
+
+/* sgemv_row_kernel()
+ *
+ * @param: A = row major m x n matrix
+ * @param: x = input vector of n elements
+ * @param: y = output vector of m elements
+ * @param: m = number of rows
+ * @param: n = number of cols
+ * @param: lda = distance between rows of A (>= n)
+ *
+ * @return: y = A * x
+ *
+ * Local SGEMV for blocks of rows, used by the row and checkerboard decompositions.
+ */
+void sgemv_row_kernel(const float *A, const float *x, float *y, int m, int n, int lda)
+{
+    kernels().row(A, x, y, m, n, lda);
+}
+
+
+/* sgemv_col_kernel()
+ *
+ * @param: A = col major m x n matrix
+ * @param: x = input vector of n elements
+ * @param: y = output vector of m elements
+ * @param: m = number of rows
+ * @param: n = number of cols
+ * @param: lda = distance between cols of A (>= m)
+ *
+ * @return: y = A * x
+ *
+ * Local SGEMV for blocks of cols, used by the col decompositions.
+ */
+void sgemv_col_kernel(const float *A, const float *x, float *y, int m, int n, int lda)
+{
+    kernels().col(A, x, y, m, n, lda);
+}
+
+
+/* sgemv_row_kernel_batch()
+ *
+ * @param: A = row major m x n matrix
+ * @param: X = row major n x k block of vectors
+ * @param: Y = row major m x k block of output vectors
+ * @param: m = number of rows
+ * @param: n = number of cols
+ * @param: k = number of vectors
+ * @param: lda = distance between rows of A (>= n)
+ *
+ * @return: Y = A * X
+ *
+ * Batched version of sgemv_row_kernel(). A is read once for every tile of up to 16 (AVX2) or 32
+ * (AVX-512) vectors instead of once per vector.
+ */
+void sgemv_row_kernel_batch(const float *A, const float *X, float *Y, int m, int n, int k,
+        int lda)
+{
+    kernels().batch(A, X, Y, m, n, k, lda, 1);
+}
+
+
+/* sgemv_col_kernel_batch()
+ *
+ * @param: A = col major m x n matrix
+ * @param: X = row major n x k block of vectors
+ * @param: Y = row major m x k block of output vectors
+ * @param: m = number of rows
+ * @param: n = number of cols
+ * @param: k = number of vectors
+ * @param: lda = distance between cols of A (>= m)
+ *
+ * @return: Y = A * X
+ *
+ * Batched version of sgemv_col_kernel().
+ */
+void sgemv_col_kernel_batch(const float *A, const float *X, float *Y, int m, int n, int k,
+        int lda)
+{
+    kernels().batch(A, X, Y, m, n, k, 1, lda);
+}
@@ -0,0 +1,17 @@
+/* Written by : Eric Tan
+ *
+ * Local SGEMV kernels used by every decomposition. Each kernel has a scalar, AVX2 and AVX-512
+ * version. The fastest version the CPU supports is picked the first time a kernel is called.
+ */
+
+#pragma once
+
+
+/* FUNCTIONS
+ */
+void sgemv_row_kernel(const float *A, const float *x, float *y, int m, int n, int lda);
+void sgemv_col_kernel(const float *A, const float *x, float *y, int m, int n, int lda);
+void sgemv_row_kernel_batch(const float *A, const float *X, float *Y, int m, int n, int k,
+        int lda);
+void sgemv_col_kernel_batch(const float *A, const float *X, float *Y, int m, int n, int k,
+        int lda);
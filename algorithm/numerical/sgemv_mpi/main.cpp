@@ -1,11 +1,16 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cmath>
 #include <mpi.h>
 
 #include "vector.h"
 #include "matrix.h"
 #include "mpi_utility.h"
+#include "kernel.h"
+#include "dist_matrix.h"
+#include "dist_vector.h"
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -15,6 +20,10 @@ void row_replicated_sgemv(const std::string &mat, const std::string &vec, int p,
 void row_block_sgemv(const std::string &mat, const std::string &vec, int p, int id);
 void col_replicated_sgemv(const std::string &mat, const std::string &vec, int p, int id);
 void col_block_sgemv(const std::string &mat, const std::string &vec, int p, int id);
+void checkerboard_sgemv(const std::string &mat, const std::string &vec, int p, int id);
+void row_batched_sgemv(const std::string &mat, const std::string &vecs, int p, int id);
+void col_batched_sgemv(const std::string &mat, const std::string &vecs, int p, int id);
+void dist_sgemv(const std::string &mat, const std::string &vec, int p, int id);
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -27,9 +36,10 @@ int main(int argc, char **argv)
     MPI_Comm_size(MPI_COMM_WORLD, &p);
     MPI_Comm_rank(MPI_COMM_WORLD, &id);
 
-    if (argc != 3) {
+    if (argc != 3 && argc != 4) {
         if (!id)
-            std::cerr << "Error: Expected 2 inputs.\n" << argv[0] << "matrix vector\n";
+            std::cerr << "Error: Expected 2 or 3 inputs.\n" << argv[0]
+                << " matrix vector [vectors]\n";
 
         MPI_Finalize();
         exit(EXIT_FAILURE);
@@ -39,6 +49,14 @@ int main(int argc, char **argv)
     row_block_sgemv(argv[1], argv[2], p, id);
     col_replicated_sgemv(argv[1], argv[2], p, id);
     col_block_sgemv(argv[1], argv[2], p, id);
+    checkerboard_sgemv(argv[1], argv[2], p, id);
+    dist_sgemv(argv[1], argv[2], p, id);
+
+    // Optional block of vectors, stored as an n x k matrix
+    if (argc == 4) {
+        row_batched_sgemv(argv[1], argv[3], p, id);
+        col_batched_sgemv(argv[1], argv[3], p, id);
+    } // Batched modes
 
     MPI_Finalize();
 }
@@ -86,11 +104,7 @@ void row_replicated_sgemv(const std::string &mat, const std::string &vec, int p,
     // matrix vector multiply with the submatrix, and the full vector, so we are left with
     // local_rows elements in the resulting vector c. Thus, we need to combine the blocks of c into
     // a full vector.
-    for (int i = 0; i < local_rows; i++) {
-        c_blk[i] = 0.0;
-        for (int j = 0; j < n; j++)
-            c_blk[i] += A[i * n + j] * b[j];
-    } // Loop over local_rows
+    sgemv_row_kernel(A, b, c_blk, local_rows, n, n);
 
     replicate_block_vector(c_blk, dim.first, &c, MPI_COMM_WORLD);
     print_replicated_vector(c, dim.first, MPI_COMM_WORLD);
@@ -144,11 +158,7 @@ void row_block_sgemv(const std::string &mat, const std::string &vec, int p, int
     MPI_Allgatherv(b, cnt[id], MPI_FLOAT, replicate_b,
             cnt.data(), disp.data(), MPI_FLOAT, MPI_COMM_WORLD);
 
-    for (int i = 0; i < m_blk; i++) {
-        c[i] = 0.0;
-        for (int j = 0; j < n; j++)
-            c[i] += A[i * n + j] * replicate_b[j];
-    } // Loop over rows in block
+    sgemv_row_kernel(A, replicate_b, c, m_blk, n, n);
 
     print_block_vector(c, dim.first, MPI_COMM_WORLD);
 
@@ -198,11 +208,7 @@ void col_replicated_sgemv(const std::string &mat, const std::string &vec, int p,
     // Compute partial results of c. There are local_cols worth of elements to perform
     // the matrix vector multiplication, so we will only have the partial result.
     // The subvector is offset byblk_idx
-    for (int i = 0; i < dim.first; i++) {
-        partial_c[i] = 0.0;
-        for (int j = 0; j < local_cols; j++)
-            partial_c[i] += A[i * local_cols + j] * b[blk_idx + j];
-    } // Loop over rows
+    sgemv_col_kernel(A, b + blk_idx, partial_c, dim.first, local_cols, dim.first);
 
     float *partial_c_blk = new float[p * local_rows];
     float *c_blk = new float[local_rows];
@@ -268,11 +274,7 @@ void col_block_sgemv(const std::string &mat, const std::string &vec, int p, int
 
     // Compute partial results. We will dot every row in our portion of A with the corresponding
     // block b.
-    for (int i = 0; i < dim.first; i++) {
-        partial_c[i] = 0.0;
-        for (int j = 0; j < local_cols; j++)
-            partial_c[i] += A[i * local_cols + j] * b[j];
-    } // Loop over rows
+    sgemv_col_kernel(A, b, partial_c, dim.first, local_cols, dim.first);
 
     // In order to get the blocks for c, we need to do an all to all with partial_c so that
     // the correct procs get every partial_c element to sum.
@@ -299,3 +301,255 @@ void col_block_sgemv(const std::string &mat, const std::string &vec, int p, int
     delete[] partial_c_blk;
     delete[] c;
 }
+
+
+/* checkerboard_sgemv()
+ *
+ * @param: mat = matrix filenmame
+ * @param: vec = vector filename
+ * @param: p = number of procs
+ * @param: id = proc rank
+ *
+ * Implamentation of SGEMV with a checkerboard (2D block) decomposed matrix on a sqrt(p) x sqrt(p)
+ * process grid. Each proc holds the block of b matching its matrix cols, and the output vector c
+ * is a block vector over the procs in grid col 0. Every proc only communicates O(n / sqrt(p))
+ * elements, compared to O(n) for the 1D decompositions.
+ */
+void checkerboard_sgemv(const std::string &mat, const std::string &vec, int p, int id)
+{
+    float *A, *b;
+    int dims[2] = {0, 0};
+    int periods[2] = {0, 0};
+    int coords[2];
+    int row_dims[2] = {0, 1};
+    int col_dims[2] = {1, 0};
+    MPI_Comm grid_comm, row_comm, col_comm;
+
+    // Create the grid. MPI_Dims_create gives sqrt(p) x sqrt(p) for square p and the closest
+    // shape otherwise. Ranks are not reordered, so grid rank matches id.
+    MPI_Dims_create(p, 2, dims);
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &grid_comm);
+    MPI_Cart_coords(grid_comm, id, 2, coords);
+    MPI_Cart_sub(grid_comm, row_dims, &row_comm);
+    MPI_Cart_sub(grid_comm, col_dims, &col_comm);
+
+    dim2 dim = read_checkerboard_matrix(mat, &A, grid_comm);
+    int n = read_checkerboard_vector(vec, &b, row_comm, col_comm);
+
+    if (dim.second != n) {
+        if (!id)
+            std::cerr << "Error: Mismatched column and vector dimension.\n" << "Matrix dim = "
+                << dim.first << " x " << dim.second << " Vector dim = " << n << '\n';
+        delete[] A;
+        delete[] b;
+        MPI_Comm_free(&row_comm);
+        MPI_Comm_free(&col_comm);
+        MPI_Comm_free(&grid_comm);
+        return;
+    } // Check if dimensions are the same
+
+    // SGEMV Implamentation
+    int local_rows = block_size(coords[0], dims[0], dim.first);
+    int local_cols = block_size(coords[1], dims[1], n);
+    float *partial_c = new float[local_rows];
+    float *c = new float[local_rows];
+
+    // Each proc multiplies its block of A with its block of b, which gives a partial result for
+    // the rows of its grid row.
+    sgemv_row_kernel(A, b, partial_c, local_rows, local_cols, local_cols);
+
+    // Sum the partial results across every grid row into grid col 0. Grid col 0 then holds c as
+    // a block vector over its col communicator.
+    MPI_Reduce(partial_c, c, local_rows, MPI_FLOAT, MPI_SUM, 0, row_comm);
+
+    if (!coords[1])
+        print_block_vector(c, dim.first, col_comm);
+
+    delete[] A;
+    delete[] b;
+    delete[] partial_c;
+    delete[] c;
+    MPI_Comm_free(&row_comm);
+    MPI_Comm_free(&col_comm);
+    MPI_Comm_free(&grid_comm);
+}
+
+
+/* row_batched_sgemv()
+ *
+ * @param: mat = matrix filenmame
+ * @param: vecs = filename of a block of k vectors, stored as an n x k matrix
+ * @param: p = number of procs
+ * @param: id = proc rank
+ *
+ * Batched version of row_block_sgemv(). A row striped matrix is multiplied by k block vectors at
+ * once. A single MPI_Allgatherv replicates all k vectors, and every element of A is read once for
+ * the whole batch. Output is a block of k vectors, distributed by rows.
+ */
+void row_batched_sgemv(const std::string &mat, const std::string &vecs, int p, int id)
+{
+    float *A, *B;
+
+    dim2 dim = read_row_matrix(mat, &A, MPI_COMM_WORLD);
+    dim2 b_dim = read_row_matrix(vecs, &B, MPI_COMM_WORLD);
+    int n = b_dim.first;
+    int k = b_dim.second;
+
+    if (dim.second != n) {
+        if (!id)
+            std::cerr << "Error: Mismatched column and vector dimension.\n" << "Matrix dim = "
+                << dim.first << " x " << dim.second << " Vector dim = " << n << '\n';
+        delete[] A;
+        delete[] B;
+        return;
+    } // Check if dimensions are the same
+
+    // SGEMV implamentation
+    int local_rows = block_size(id, p, dim.first);
+    float *C = new float[static_cast<size_t>(local_rows) * k];
+    float *replicate_B;
+
+    replicate_block_vector(B, n, &replicate_B, MPI_COMM_WORLD, k);
+    sgemv_row_kernel_batch(A, replicate_B, C, local_rows, n, k, n);
+
+    print_row_matrix(C, std::make_pair(dim.first, k), MPI_COMM_WORLD);
+
+    delete[] A;
+    delete[] B;
+    delete[] replicate_B;
+    delete[] C;
+}
+
+
+/* col_batched_sgemv()
+ *
+ * @param: mat = matrix filenmame
+ * @param: vecs = filename of a block of k vectors, stored as an n x k matrix
+ * @param: p = number of procs
+ * @param: id = proc rank
+ *
+ * Batched version of col_block_sgemv(). A col striped matrix is multiplied by k block vectors at
+ * once. The partial results of all k vectors go through a single MPI_Alltoallv. Output is a block
+ * of k vectors, distributed by rows.
+ */
+void col_batched_sgemv(const std::string &mat, const std::string &vecs, int p, int id)
+{
+    float *A, *B;
+
+    dim2 dim = read_col_matrix(mat, &A, MPI_COMM_WORLD);
+    dim2 b_dim = read_row_matrix(vecs, &B, MPI_COMM_WORLD);
+    int n = b_dim.first;
+    int k = b_dim.second;
+
+    if (dim.second != n) {
+        if (!id)
+            std::cerr << "Error: Mismatched column and vector dimension.\n" << "Matrix dim = "
+                << dim.first << " x " << dim.second << " Vector dim = " << n << '\n';
+        delete[] A;
+        delete[] B;
+        return;
+    } // Check if dimensions are the same
+
+    // SGEMV Implamentation
+    int local_rows = block_size(id, p, dim.first);
+    int local_cols = block_size(id, p, n);
+    float *partial_C = new float[static_cast<size_t>(dim.first) * k];
+
+    // Partial results for every row of every vector. Rows of partial_C are k vectors wide, so each
+    // proc's block of rows is still contiguous.
+    sgemv_col_kernel_batch(A, B, partial_C, dim.first, local_cols, k, dim.first);
+
+    std::vector<int> cnt_out, disp_out, cnt_in, disp_in;
+    float *partial_C_blk = new float[static_cast<size_t>(p) * local_rows * k];
+    float *C = new float[static_cast<size_t>(local_rows) * k];
+
+    make_mixed_xfer_array(p, dim.first, cnt_out, disp_out, k);
+    make_uniform_xfer_array(id, p, dim.first, cnt_in, disp_in, k);
+    MPI_Alltoallv(partial_C, cnt_out.data(), disp_out.data(), MPI_FLOAT, partial_C_blk,
+            cnt_in.data(), disp_in.data(), MPI_FLOAT, MPI_COMM_WORLD);
+
+    size_t blk_size = static_cast<size_t>(local_rows) * k;
+    for (size_t i = 0; i < blk_size; i++) {
+        C[i] = 0.0;
+        for (int j = 0; j < p; j++)
+            C[i] += partial_C_blk[i + j * blk_size];
+    } // Loop over elements in C
+
+    print_row_matrix(C, std::make_pair(dim.first, k), MPI_COMM_WORLD);
+
+    delete[] A;
+    delete[] B;
+    delete[] partial_C;
+    delete[] partial_C_blk;
+    delete[] C;
+}
+
+
+/* dist_sgemv()
+ *
+ * @param: mat = matrix filenmame
+ * @param: vec = vector filename
+ * @param: p = number of procs (unused, DistMatrix reads it from the communicator)
+ * @param: id = proc rank
+ *
+ * SGEMV through DistMatrix and DistVector with both decompositions. The matrices build their
+ * communication plans when they are read, so each multiply() only runs the plan. The same b and c
+ * are then reused over several iterations, as they would be in a solver. b is scaled by -2 each
+ * iteration, which is exact in floating point, so each decomposition's c must be its first c
+ * scaled the same way.
+ */
+void dist_sgemv(const std::string &mat, const std::string &vec, int /* p */, int id)
+{
+    const int iters = 4;
+
+    DistVector b(vec, MPI_COMM_WORLD);
+    DistMatrix A_row(mat, DistMatrix::ROW, MPI_COMM_WORLD);
+    DistMatrix A_col(mat, DistMatrix::COL, MPI_COMM_WORLD);
+    dim2 dim = A_row.dim();
+
+    if (dim.second != b.size()) {
+        if (!id)
+            std::cerr << "Error: Mismatched column and vector dimension.\n" << "Matrix dim = "
+                << dim.first << " x " << dim.second << " Vector dim = " << b.size() << '\n';
+        return;
+    } // Check if dimensions are the same
+
+    DistVector c(dim.first, MPI_COMM_WORLD);
+
+    A_row.multiply(b, c);
+    c.print();
+    std::vector<float> row_c(c.data(), c.data() + c.local_size());
+
+    A_col.multiply(b, c);
+    c.print();
+    std::vector<float> col_c(c.data(), c.data() + c.local_size());
+
+    int mismatches = 0;
+    for (int it = 1; it <= iters; it++) {
+        float *b_blk = b.data();
+        for (int i = 0; i < b.local_size(); i++)
+            b_blk[i] *= -2.0f;
+
+        for (int i = 0; i < c.local_size(); i++) {
+            row_c[i] *= -2.0f;
+            col_c[i] *= -2.0f;
+        } // Loop over expected elements of c
+
+        A_row.multiply(b, c);
+        for (int i = 0; i < c.local_size(); i++) {
+            if (std::fabs(c.data()[i] - row_c[i]) > 1e-6f * std::fabs(row_c[i]))
+                mismatches++;
+        } // Loop over elements in c
+
+        A_col.multiply(b, c);
+        for (int i = 0; i < c.local_size(); i++) {
+            if (std::fabs(c.data()[i] - col_c[i]) > 1e-6f * std::fabs(col_c[i]))
+                mismatches++;
+        } // Loop over elements in c
+    } // Loop over iterations
+
+    MPI_Allreduce(MPI_IN_PLACE, &mismatches, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (!id && mismatches)
+        std::cerr << "Error: " << mismatches << " elements of c differ after repeated multiply()"
+            << " calls.\n";
+}
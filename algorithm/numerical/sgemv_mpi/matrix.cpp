@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <cstddef>
 
 #include "matrix.h"
 #include "vector.h"
@@ -21,9 +22,13 @@
  * @return: matrix returned through A
  *
  * Reads in and decomposes a matrix by rows. Proc p-1 handles reading and distributing matrix.
+ * Files ending in .bin are read with read_row_matrix_binary() instead.
  */
 dim2 read_row_matrix(const std::string &filename, float **A, MPI_Comm comm)
 {
+    if (is_binary_matrix(filename))
+        return read_row_matrix_binary(filename, A, comm);
+
     std::ifstream inf(filename);
     int p, id;
     int m, n;
@@ -43,7 +48,7 @@ dim2 read_row_matrix(const std::string &filename, float **A, MPI_Comm comm)
 
     // Allocate buffer
     int local_rows = block_size(id, p, m);
-    *A = new float[local_rows * n];
+    *A = new float[static_cast<size_t>(local_rows) * n];
 
     if (id == (p - 1)) {
         for (int i = 0; i < p - 1; i++) {
@@ -55,7 +60,7 @@ dim2 read_row_matrix(const std::string &filename, float **A, MPI_Comm comm)
         } // Reads and distributes matrix to all procs except p-1
 
         // Proc p-1 read its peice
-        for (int i = 0; i < local_rows * n; i++)
+        for (size_t i = 0; i < static_cast<size_t>(local_rows) * n; i++)
             inf >> (*A)[i];
 
     } else {
@@ -79,10 +84,15 @@ dim2 read_row_matrix(const std::string &filename, float **A, MPI_Comm comm)
  * @return: matrix returned through A
  *
  * Reads in and decomposes a matrix by cols. Proc p-1 handles reading the matrix and elements are
- * distributed through scatterv.
+ * distributed through scatterv. Each proc stores its cols in col major order, so element (i, j)
+ * of its block is A[j * m + i]. Files ending in .bin are read with read_col_matrix_binary()
+ * instead.
  */
 dim2 read_col_matrix(const std::string &filename, float **A, MPI_Comm comm)
 {
+    if (is_binary_matrix(filename))
+        return read_col_matrix_binary(filename, A, comm);
+
     std::ifstream inf(filename);
     int id, p;
     int m, n;
@@ -102,7 +112,7 @@ dim2 read_col_matrix(const std::string &filename, float **A, MPI_Comm comm)
 
     // Allocate buffer
     int local_cols = block_size(id, p, n);
-    *A = new float[m * local_cols];
+    *A = new float[static_cast<size_t>(m) * local_cols];
 
     // create arrays for transfering rows
     std::vector<int> cnt, disp;
@@ -110,6 +120,7 @@ dim2 read_col_matrix(const std::string &filename, float **A, MPI_Comm comm)
 
     // Use a buffer for reading rows
     std::vector<float> buffer(n);
+    std::vector<float> row(local_cols);
 
     for (int i = 0; i < m; i++) {
         // Read into buffer
@@ -118,8 +129,11 @@ dim2 read_col_matrix(const std::string &filename, float **A, MPI_Comm comm)
                 inf >> buffer[j];
 
         // Distribute row to corresponding columns
-        MPI_Scatterv(buffer.data(), cnt.data(), disp.data(), MPI_FLOAT, (*A) + (i * local_cols),
-                local_cols, MPI_FLOAT, p - 1, comm);
+        MPI_Scatterv(buffer.data(), cnt.data(), disp.data(), MPI_FLOAT, row.data(), local_cols,
+                MPI_FLOAT, p - 1, comm);
+
+        for (int j = 0; j < local_cols; j++)
+            (*A)[static_cast<size_t>(j) * m + i] = row[j];
     } // Loop over all rows
 
     inf.close();
@@ -127,6 +141,311 @@ dim2 read_col_matrix(const std::string &filename, float **A, MPI_Comm comm)
     return std::make_pair(m, n);
 }
 
+/* read_checkerboard_matrix()
+ *
+ * @param: filename = input filename
+ * @param: A = point to matrix (as array)
+ * @param: grid_comm = 2D Cartesian MPI communicator
+ *
+ * @return: dimension of matrix
+ * @return: matrix returned through A
+ *
+ * Reads in and decomposes a matrix into blocks over a 2D process grid. The proc at grid
+ * coordinates (r, c) gets rows block r and cols block c, stored row major. Proc p-1 reads one
+ * grid row's worth of matrix rows at a time and sends every proc in that grid row its block.
+ * Files ending in .bin are read with read_checkerboard_matrix_binary() instead.
+ */
+dim2 read_checkerboard_matrix(const std::string &filename, float **A, MPI_Comm grid_comm)
+{
+    if (is_binary_matrix(filename))
+        return read_checkerboard_matrix_binary(filename, A, grid_comm);
+
+    std::ifstream inf(filename);
+    int p, id;
+    int m, n;
+    int dims[2], periods[2], coords[2];
+
+    MPI_Comm_size(grid_comm, &p);
+    MPI_Comm_rank(grid_comm, &id);
+    MPI_Cart_get(grid_comm, 2, dims, periods, coords);
+
+    if (!inf.is_open())
+        MPI_Abort(grid_comm, OPEN_FILE_ERROR);
+
+    if (id == (p - 1))
+        inf >> m >> n;
+
+    // Broadcast m and n
+    MPI_Bcast(&m, 1, MPI_INT, p - 1, grid_comm);
+    MPI_Bcast(&n, 1, MPI_INT, p - 1, grid_comm);
+
+    // Allocate buffer
+    int local_rows = block_size(coords[0], dims[0], m);
+    int local_cols = block_size(coords[1], dims[1], n);
+    *A = new float[static_cast<size_t>(local_rows) * local_cols];
+
+    if (id == (p - 1)) {
+        int max_rows = block_size(dims[0] - 1, dims[0], m);
+        int max_cols = block_size(dims[1] - 1, dims[1], n);
+        std::vector<float> buffer(static_cast<size_t>(max_rows) * n);
+        std::vector<float> blk(static_cast<size_t>(max_rows) * max_cols);
+
+        for (int r = 0; r < dims[0]; r++) {
+            int rows = block_size(r, dims[0], m);
+            for (size_t j = 0; j < static_cast<size_t>(rows) * n; j++)
+                inf >> buffer[j];
+
+            for (int c = 0; c < dims[1]; c++) {
+                int cols = block_size(c, dims[1], n);
+                int col_low = block_low(c, dims[1], n);
+                int dest_coords[2] = {r, c};
+                int dest;
+
+                MPI_Cart_rank(grid_comm, dest_coords, &dest);
+
+                // Copy the block out of the rows, straight into A for proc p-1's own block
+                float *dest_blk = (dest == id) ? *A : blk.data();
+                for (int i = 0; i < rows; i++)
+                    for (int j = 0; j < cols; j++)
+                        dest_blk[static_cast<size_t>(i) * cols + j] =
+                            buffer[static_cast<size_t>(i) * n + col_low + j];
+
+                if (dest != id)
+                    MPI_Send(blk.data(), rows * cols, MPI_FLOAT, dest, DATA_MSG, grid_comm);
+            } // Loop over grid cols
+        } // Loop over grid rows
+    } else {
+        MPI_Status stat;
+        MPI_Recv(*A, local_rows * local_cols, MPI_FLOAT, p - 1, DATA_MSG, grid_comm, &stat);
+    } // Distribute matrix blocks
+
+    inf.close();
+
+    return std::make_pair(m, n);
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * BINARY INPUT FUNCTIONS
+ *
+ * Binary matrix files hold two ints (m and n) followed by the m x n matrix as row major floats.
+ * Every proc reads its own part of the file with a single collective MPI_File_read_all.
+ *-----------------------------------------------------------------------------------------------*/
+
+constexpr MPI_Offset BINARY_HEADER = 2 * sizeof(int);
+
+
+/* open_binary_matrix()
+ *
+ * @param: filename = input filename
+ * @param: dim = dimension of matrix
+ * @param: comm = MPI communicator
+ *
+ * @return: opened file
+ * @return: dimension of matrix through dim
+ *
+ * Opens a binary matrix on every proc and reads the header. Aborts if the file can not be opened
+ * or its size does not match the header.
+ */
+static MPI_File open_binary_matrix(const std::string &filename, dim2 &dim, MPI_Comm comm)
+{
+    MPI_File fh;
+    MPI_Offset file_size;
+    int header[2];
+
+    if (MPI_File_open(comm, filename.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        MPI_Abort(comm, OPEN_FILE_ERROR);
+
+    // Check the file holds a header before reading it
+    MPI_File_get_size(fh, &file_size);
+    if (file_size < BINARY_HEADER)
+        MPI_Abort(comm, FILE_FORMAT_ERROR);
+
+    MPI_File_read_at_all(fh, 0, header, 2, MPI_INT, MPI_STATUS_IGNORE);
+
+    MPI_Offset expected = BINARY_HEADER +
+        static_cast<MPI_Offset>(header[0]) * header[1] * sizeof(float);
+    if (header[0] < 0 || header[1] < 0 || file_size != expected)
+        MPI_Abort(comm, FILE_FORMAT_ERROR);
+
+    dim = std::make_pair(header[0], header[1]);
+
+    return fh;
+}
+
+
+/* read_row_matrix_binary()
+ *
+ * @param: filename = input filename
+ * @param: A = point to matrix (as array)
+ * @param: comm = MPI communicator
+ *
+ * @return: dimension of matrix
+ * @return: matrix returned through A
+ *
+ * Binary version of read_row_matrix(). Each proc's rows are contiguous in the file, so every proc
+ * sets its view to the start of its rows and reads them as whole rows.
+ */
+dim2 read_row_matrix_binary(const std::string &filename, float **A, MPI_Comm comm)
+{
+    int p, id;
+    dim2 dim;
+    MPI_Datatype row;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &id);
+
+    MPI_File fh = open_binary_matrix(filename, dim, comm);
+
+    // Allocate buffer
+    int local_rows = block_size(id, p, dim.first);
+    *A = new float[static_cast<size_t>(local_rows) * dim.second];
+
+    // Read whole rows, so the count stays small for large matrices
+    MPI_Type_contiguous(dim.second, MPI_FLOAT, &row);
+    MPI_Type_commit(&row);
+
+    MPI_Offset offset = BINARY_HEADER +
+        static_cast<MPI_Offset>(block_low(id, p, dim.first)) * dim.second * sizeof(float);
+    MPI_File_set_view(fh, offset, MPI_FLOAT, MPI_FLOAT, "native", MPI_INFO_NULL);
+    MPI_File_read_all(fh, *A, local_rows, row, MPI_STATUS_IGNORE);
+
+    MPI_Type_free(&row);
+    MPI_File_close(&fh);
+
+    return dim;
+}
+
+
+/* read_col_matrix_binary()
+ *
+ * @param: filename = input filename
+ * @param: A = point to matrix (as array)
+ * @param: comm = MPI communicator
+ *
+ * @return: dimension of matrix
+ * @return: matrix returned through A
+ *
+ * Binary version of read_col_matrix(). The file view is a subarray covering the proc's cols, and
+ * the memory datatype places each row of the panel with a stride of m, so the panel lands in
+ * col major order without an extra copy.
+ */
+dim2 read_col_matrix_binary(const std::string &filename, float **A, MPI_Comm comm)
+{
+    int p, id;
+    dim2 dim;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &id);
+
+    MPI_File fh = open_binary_matrix(filename, dim, comm);
+
+    // Allocate buffer
+    int m = dim.first;
+    int local_cols = block_size(id, p, dim.second);
+    *A = new float[static_cast<size_t>(m) * local_cols];
+
+    if (m > 0 && local_cols > 0) {
+        MPI_Datatype panel, strided, row;
+        int sizes[2] = {m, dim.second};
+        int subsizes[2] = {m, local_cols};
+        int starts[2] = {0, block_low(id, p, dim.second)};
+
+        MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_FLOAT, &panel);
+        MPI_Type_commit(&panel);
+
+        // One row of the panel in col major memory, resized so consecutive rows are 1 float apart
+        MPI_Type_vector(local_cols, 1, m, MPI_FLOAT, &strided);
+        MPI_Type_create_resized(strided, 0, sizeof(float), &row);
+        MPI_Type_commit(&row);
+
+        MPI_File_set_view(fh, BINARY_HEADER, MPI_FLOAT, panel, "native", MPI_INFO_NULL);
+        MPI_File_read_all(fh, *A, m, row, MPI_STATUS_IGNORE);
+
+        MPI_Type_free(&panel);
+        MPI_Type_free(&strided);
+        MPI_Type_free(&row);
+    } else {
+        MPI_File_set_view(fh, BINARY_HEADER, MPI_FLOAT, MPI_FLOAT, "native", MPI_INFO_NULL);
+        MPI_File_read_all(fh, *A, 0, MPI_FLOAT, MPI_STATUS_IGNORE);
+    } // Procs without cols still join the collective read
+
+    MPI_File_close(&fh);
+
+    return dim;
+}
+
+
+/* read_checkerboard_matrix_binary()
+ *
+ * @param: filename = input filename
+ * @param: A = point to matrix (as array)
+ * @param: grid_comm = 2D Cartesian MPI communicator
+ *
+ * @return: dimension of matrix
+ * @return: matrix returned through A
+ *
+ * Binary version of read_checkerboard_matrix(). The file view is a subarray covering the proc's
+ * block.
+ */
+dim2 read_checkerboard_matrix_binary(const std::string &filename, float **A, MPI_Comm grid_comm)
+{
+    int dims[2], periods[2], coords[2];
+    dim2 dim;
+
+    MPI_Cart_get(grid_comm, 2, dims, periods, coords);
+
+    MPI_File fh = open_binary_matrix(filename, dim, grid_comm);
+
+    // Allocate buffer
+    int local_rows = block_size(coords[0], dims[0], dim.first);
+    int local_cols = block_size(coords[1], dims[1], dim.second);
+    *A = new float[static_cast<size_t>(local_rows) * local_cols];
+
+    if (local_rows > 0 && local_cols > 0) {
+        MPI_Datatype block, row;
+        int sizes[2] = {dim.first, dim.second};
+        int subsizes[2] = {local_rows, local_cols};
+        int starts[2] = {block_low(coords[0], dims[0], dim.first),
+            block_low(coords[1], dims[1], dim.second)};
+
+        MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_FLOAT, &block);
+        MPI_Type_commit(&block);
+
+        // Read whole rows of the block, so the count stays small for large matrices
+        MPI_Type_contiguous(local_cols, MPI_FLOAT, &row);
+        MPI_Type_commit(&row);
+
+        MPI_File_set_view(fh, BINARY_HEADER, MPI_FLOAT, block, "native", MPI_INFO_NULL);
+        MPI_File_read_all(fh, *A, local_rows, row, MPI_STATUS_IGNORE);
+
+        MPI_Type_free(&block);
+        MPI_Type_free(&row);
+    } else {
+        MPI_File_set_view(fh, BINARY_HEADER, MPI_FLOAT, MPI_FLOAT, "native", MPI_INFO_NULL);
+        MPI_File_read_all(fh, *A, 0, MPI_FLOAT, MPI_STATUS_IGNORE);
+    } // Procs without a block still join the collective read
+
+    MPI_File_close(&fh);
+
+    return dim;
+}
+
+
+/* is_binary_matrix()
+ *
+ * @param: filename = input filename
+ *
+ * @return: true if the file name ends in .bin
+ */
+bool is_binary_matrix(const std::string &filename)
+{
+    const std::string ext = ".bin";
+
+    return filename.size() >= ext.size() &&
+        filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
 
 /*-------------------------------------------------------------------------------------------------
  * OUTPUT FUNCTIONS
@@ -156,7 +475,7 @@ void print_row_matrix(const float *A, const dim2 &dim, MPI_Comm comm)
 
         if (p > 1) {
             int max_blk_size = block_size(p - 1, p, dim.first);
-            std::vector<float> buffer(max_blk_size * dim.second);
+            std::vector<float> buffer(static_cast<size_t>(max_blk_size) * dim.second);
 
             for (int i = 1; i < p; i++) {
                 int recv_blks = block_size(i, p, dim.first);
@@ -181,8 +500,8 @@ void print_row_matrix(const float *A, const dim2 &dim, MPI_Comm comm)
  * @param: dim = dimensions of the matrix
  * @param: comm = MPI Communicator
  *
- * Prints a col decomposed matrix. Gathers rows into a buffer so that the buffer stores an entire
- * row of a matrix.
+ * Prints a col decomposed matrix stored in col major order. Gathers rows into a buffer so that the
+ * buffer stores an entire row of a matrix.
  */
 void print_col_matrix(const float *A, const dim2 &dim, MPI_Comm comm)
 {
@@ -195,10 +514,14 @@ void print_col_matrix(const float *A, const dim2 &dim, MPI_Comm comm)
 
     int local_cols = block_size(id, p, dim.second);
     std::vector<float> buffer(dim.second);
+    std::vector<float> row(local_cols);
 
     for (int i = 0; i < dim.first; i++) {
-        MPI_Gatherv(A + (i * local_cols), block_size(id, p, dim.second), MPI_FLOAT, buffer.data(),
-                    cnt.data(), disp.data(), MPI_FLOAT, 0, comm);
+        for (int j = 0; j < local_cols; j++)
+            row[j] = A[static_cast<size_t>(j) * dim.first + i];
+
+        MPI_Gatherv(row.data(), local_cols, MPI_FLOAT, buffer.data(), cnt.data(), disp.data(),
+                    MPI_FLOAT, 0, comm);
 
         if (!id) {
             print_subvector(buffer.data(), dim.second);
@@ -223,8 +546,57 @@ void print_submatrix(const float *A, int m, int n)
 {
     for (int i = 0; i < m; i++) {
         for (int j = 0; j < n; j++) {
-            std::cout << std::right << std::setw(6) << std::setprecision(4) << A[i * n + j] << ' ';
+            std::cout << std::right << std::setw(6) << std::setprecision(4)
+                << A[static_cast<size_t>(i) * n + j] << ' ';
         } // Col loop
         std::cout << '\n';
     } // Row loop
 }
+
+
+/*-------------------------------------------------------------------------------------------------
+ * CONVERSION FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* convert_matrix_to_binary()
+ *
+ * @param: text_file = input filename, in the text format read by read_row_matrix()
+ * @param: binary_file = output filename
+ *
+ * @return: 0 on success, OPEN_FILE_ERROR if either file can not be opened, FILE_FORMAT_ERROR if
+ *          the text matrix is cut short
+ *
+ * Converts a text matrix into the binary format. Works one row at a time, so the matrix never has
+ * to fit in memory. Does not use MPI.
+ */
+int convert_matrix_to_binary(const std::string &text_file, const std::string &binary_file)
+{
+    std::ifstream inf(text_file);
+    int header[2];
+
+    if (!inf.is_open())
+        return OPEN_FILE_ERROR;
+
+    inf >> header[0] >> header[1];
+    if (inf.fail() || header[0] < 0 || header[1] < 0)
+        return FILE_FORMAT_ERROR;
+
+    std::ofstream outf(binary_file, std::ios::binary);
+    if (!outf.is_open())
+        return OPEN_FILE_ERROR;
+
+    outf.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<float> row(header[1]);
+    for (int i = 0; i < header[0]; i++) {
+        for (int j = 0; j < header[1]; j++)
+            inf >> row[j];
+
+        if (inf.fail())
+            return FILE_FORMAT_ERROR;
+
+        outf.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+    } // Loop over rows
+
+    return 0;
+}
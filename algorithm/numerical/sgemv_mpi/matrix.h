@@ -11,9 +11,17 @@ typedef std::pair<int, int> dim2;
 // Input
 dim2 read_row_matrix(const std::string &filename, float **A, MPI_Comm comm);
 dim2 read_col_matrix(const std::string &filename, float **A, MPI_Comm comm);
+dim2 read_checkerboard_matrix(const std::string &filename, float **A, MPI_Comm grid_comm);
+dim2 read_row_matrix_binary(const std::string &filename, float **A, MPI_Comm comm);
+dim2 read_col_matrix_binary(const std::string &filename, float **A, MPI_Comm comm);
+dim2 read_checkerboard_matrix_binary(const std::string &filename, float **A, MPI_Comm grid_comm);
+bool is_binary_matrix(const std::string &filename);
 
 // Output
 void print_row_matrix(const float *A, const dim2 &dim, MPI_Comm comm);
 void print_col_matrix(const float *A, const dim2 &dim, MPI_Comm comm);
 void print_submatrix(const float *A, int m, int n);
 
+// Conversion
+int convert_matrix_to_binary(const std::string &text_file, const std::string &binary_file);
+
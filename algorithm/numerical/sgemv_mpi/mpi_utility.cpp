@@ -49,23 +49,24 @@ int block_size(int id, int p, int n)
  * @param: n = number of elements
  * @param: cnt = vector of counts
  * @param: disp = vector of displacement
+ * @param: k = number of values per element (number of vectors in a batch)
  *
  * @return: cnt and disp
  *
  * Creates arrays used for transfering data in MPI collective communications. Required when each
  * proc's portion of data is not all the same size.
  */
-void make_mixed_xfer_array(int p, int n, std::vector<int> &cnt, std::vector<int> &disp)
+void make_mixed_xfer_array(int p, int n, std::vector<int> &cnt, std::vector<int> &disp, int k)
 {
     cnt.resize(p);
     disp.resize(p);
 
-    cnt[0]  = block_size(0, p, n);
+    cnt[0]  = block_size(0, p, n) * k;
     disp[0] = 0;
 
     for (int i = 1; i < p; i++) {
         disp[i] = disp[i - 1] + cnt[i - 1];
-        cnt[i]  = block_size(i, p, n);
+        cnt[i]  = block_size(i, p, n) * k;
     } // Set arrays
 }
 
@@ -77,22 +78,24 @@ void make_mixed_xfer_array(int p, int n, std::vector<int> &cnt, std::vector<int>
  * @param: n = number of elements
  * @param: cnt = vector of counts
  * @param: disp = vector of displacement
+ * @param: k = number of values per element (number of vectors in a batch)
  *
  * @return: cnt and disp
  *
  * Creates arrays used for transfering data in MPI collective communications.
  */
-void make_uniform_xfer_array(int id, int p, int n, std::vector<int> &cnt, std::vector<int> &disp)
+void make_uniform_xfer_array(int id, int p, int n, std::vector<int> &cnt, std::vector<int> &disp,
+        int k)
 {
     cnt.resize(p);
     disp.resize(p);
 
-    cnt[0]  = block_size(id, p, n);
+    cnt[0]  = block_size(id, p, n) * k;
     disp[0] = 0;
 
-    for (int i = 0; i < p; i++) {
+    for (int i = 1; i < p; i++) {
         disp[i] = disp[i - 1] + cnt[i - 1];
-        cnt[i]  = block_size(id, p, n);
+        cnt[i]  = block_size(id, p, n) * k;
     } // Set arrays
 }
 
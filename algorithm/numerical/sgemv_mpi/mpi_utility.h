@@ -12,6 +12,8 @@
  */
 constexpr int OPEN_FILE_ERROR = -1;
 constexpr int CMD_INPUT_ERROR = -2;
+constexpr int FILE_FORMAT_ERROR = -3;
+constexpr int DIM_MISMATCH_ERROR = -4;
 constexpr int DATA_MSG   = 1;
 constexpr int PROMPT_MSG = 2;
 
@@ -20,6 +22,7 @@ constexpr int PROMPT_MSG = 2;
 int block_low(int id, int p, int n);
 int block_high(int id, int p, int n);
 int block_size(int id, int p, int n);
-void make_mixed_xfer_array(int p, int n, std::vector<int> &cnt, std::vector<int> &disp);
-void make_uniform_xfer_array(int id, int p, int n, std::vector<int> &cnt, std::vector<int> &disp);
+void make_mixed_xfer_array(int p, int n, std::vector<int> &cnt, std::vector<int> &disp, int k = 1);
+void make_uniform_xfer_array(int id, int p, int n, std::vector<int> &cnt, std::vector<int> &disp,
+        int k = 1);
 
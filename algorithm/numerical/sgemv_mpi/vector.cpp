@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <cstddef>
 
 #include "mpi_utility.h"
 #include "vector.h"
@@ -110,6 +111,47 @@ int read_replicated_vector(const std::string &filename, float **v, MPI_Comm comm
     return n;
 }
 
+/* read_checkerboard_vector()
+ *
+ * @param: filename = file to open
+ * @param: v = pointer to array (unallocated)
+ * @param: row_comm = communicator of this proc's grid row
+ * @param: col_comm = communicator of this proc's grid col
+ *
+ * @return: size of the vector
+ * @return: block of the vector through v
+ *
+ * Reads in a vector for a checkerboard decomposed matrix. The proc at grid coordinates (r, c)
+ * gets block c of the vector, matching the cols of its matrix block. Grid row 0 reads the vector
+ * as a block vector, then every grid col broadcasts its block down the col, so each proc only
+ * handles n / sqrt(p) elements. The row and col communicators come from MPI_Cart_sub, so a
+ * proc's rank in them is its grid col and grid row.
+ */
+int read_checkerboard_vector(const std::string &filename, float **v, MPI_Comm row_comm,
+        MPI_Comm col_comm)
+{
+    int grid_row, grid_col, grid_cols;
+    int n;
+
+    MPI_Comm_rank(col_comm, &grid_row);
+    MPI_Comm_rank(row_comm, &grid_col);
+    MPI_Comm_size(row_comm, &grid_cols);
+
+    if (!grid_row)
+        n = read_block_vector(filename, v, row_comm);
+
+    // Grid row 0 is rank 0 of every col communicator
+    MPI_Bcast(&n, 1, MPI_INT, 0, col_comm);
+
+    int local_eles = block_size(grid_col, grid_cols, n);
+    if (grid_row)
+        *v = new float[local_eles];
+
+    MPI_Bcast(*v, local_eles, MPI_FLOAT, 0, col_comm);
+
+    return n;
+}
+
 
 /*-------------------------------------------------------------------------------------------------
  * OUTPUT FUNCTIONS
@@ -202,20 +244,23 @@ void print_subvector(const float *v, int n)
  * @param: n = size of vector
  * @param: v_rep = replicated vector
  * @param: comm = MPI Communicator
+ * @param: k = number of vectors
  *
  * @return: replicated vector through v_rep
  *
- * Combines blocks among procs into a replicated vectors. Returns through v_rep.
+ * Combines blocks among procs into a replicated vectors. Returns through v_rep. With k > 1, v_block
+ * holds the block rows of an n x k block of vectors (row major), and all k vectors are replicated
+ * with a single MPI_Allgatherv.
  */
-void replicate_block_vector(const float *v_block, int n, float **v_rep, MPI_Comm comm)
+void replicate_block_vector(const float *v_block, int n, float **v_rep, MPI_Comm comm, int k)
 {
     int id, p;
     std::vector<int> cnt, disp;
 
-    *v_rep = new float[n];
+    *v_rep = new float[static_cast<size_t>(n) * k];
 
     MPI_Comm_size(comm, &p);
     MPI_Comm_rank(comm, &id);
-    make_mixed_xfer_array(p, n, cnt, disp);
+    make_mixed_xfer_array(p, n, cnt, disp, k);
     MPI_Allgatherv(v_block, cnt[id], MPI_FLOAT, *v_rep, cnt.data(), disp.data(), MPI_FLOAT, comm);
 }
@@ -7,6 +7,8 @@
 // Input
 int read_block_vector(const std::string &filename, float **v, MPI_Comm comm);
 int read_replicated_vector(const std::string &filename, float **v, MPI_Comm comm);
+int read_checkerboard_vector(const std::string &filename, float **v, MPI_Comm row_comm,
+        MPI_Comm col_comm);
 
 // Output
 void print_block_vector(const float *v, int n, MPI_Comm comm);
@@ -14,4 +16,4 @@ void print_replicated_vector(const float *v, int n, MPI_Comm comm);
 void print_subvector(const float *v, int n);
 
 // Misc
-void replicate_block_vector(const float *v_block, int n, float **v_rep, MPI_Comm comm);
+void replicate_block_vector(const float *v_block, int n, float **v_rep, MPI_Comm comm, int k = 1);
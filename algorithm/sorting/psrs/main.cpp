@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cctype>
+#include <thread>
+#include <iomanip>
 
 #include <boost/mpi/environment.hpp>
 #include <boost/mpi/communicator.hpp>
@@ -19,10 +21,14 @@
  *-----------------------------------------------------------------------------------------------*/
 void test_double(const boost::mpi::communicator &comm, int N);
 void test_string(const boost::mpi::communicator &comm);
+void test_skewed(const boost::mpi::communicator &comm, int N);
+void print_stats(const psrs::sort_stats &stats);
 template <typename T>
 double time_sort(psrs::mpi_vector<T> &v);
 template <typename T, class Compare>
 double time_sort(psrs::mpi_vector<T> &v, Compare cmp);
+template <typename T, class Compare>
+double time_sort(psrs::mpi_vector<T> &v, Compare cmp, const psrs::sort_options &opts);
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -38,6 +44,7 @@ int main(int argc, char **argv)
 
     test_double(world, N);
     test_string(world);
+    test_skewed(world, N);
 }
 
 
@@ -60,7 +67,8 @@ void test_double(const boost::mpi::communicator &comm, int N)
 
     psrs::mpi_vector<double> v(comm, data.begin(), data.end(), 0);
 
-    psrs::mpi_vector<double> v_reverse(v);
+    psrs::mpi_vector<double> v_reverse(v), v_threaded(v), v_overlap(v), v_hierarchical(v),
+        v_stats(v);
 
     // Time sort with default compare
     double elapsed_time = time_sort(v);
@@ -70,6 +78,29 @@ void test_double(const boost::mpi::communicator &comm, int N)
     double reverse_elapsed_time = time_sort(v_reverse, std::greater<double>());
     v_reverse.gather(0);
 
+    // Time sort with threaded local phases
+    psrs::sort_options threaded_opts;
+    threaded_opts.threads = std::max(1u, std::thread::hardware_concurrency());
+    double threaded_elapsed_time = time_sort(v_threaded, std::less<double>(), threaded_opts);
+    v_threaded.gather(0);
+
+    // Time sort with nonblocking exchange and overlapped merge
+    psrs::sort_options overlap_opts;
+    overlap_opts.overlap = true;
+    double overlap_elapsed_time = time_sort(v_overlap, std::less<double>(), overlap_opts);
+    v_overlap.gather(0);
+
+    // Time sort with the node aware two level exchange
+    psrs::sort_options hierarchical_opts;
+    hierarchical_opts.hierarchical = true;
+    double hierarchical_elapsed_time = time_sort(v_hierarchical, std::less<double>(),
+            hierarchical_opts);
+    v_hierarchical.gather(0);
+
+    // Sort again with per phase instrumentation
+    psrs::sort_stats stats = psrs::sort(v_stats, std::less<double>(), psrs::sort_options(),
+            psrs::instrument);
+
     if (!comm.rank()) {
         std::cout << "Test double:\n";
         std::cout << "Normal Sort time: " << elapsed_time << "s : ";
@@ -77,6 +108,17 @@ void test_double(const boost::mpi::communicator &comm, int N)
         std::cout << "Reverse Sort time: " << reverse_elapsed_time << "s : ";
         std::cout << (std::is_sorted(v_reverse.begin(), v_reverse.end(), std::greater<double>()) ?
                 "Sorted correctly\n" : "Not sorted\n");
+        std::cout << "Threaded Sort time (" << threaded_opts.threads << " threads): " <<
+            threaded_elapsed_time << "s : ";
+        std::cout << (std::is_sorted(v_threaded.begin(), v_threaded.end()) ?
+                "Sorted correctly\n" : "Not sorted\n");
+        std::cout << "Overlapped Sort time: " << overlap_elapsed_time << "s : ";
+        std::cout << (std::is_sorted(v_overlap.begin(), v_overlap.end()) ?
+                "Sorted correctly\n" : "Not sorted\n");
+        std::cout << "Hierarchical Sort time: " << hierarchical_elapsed_time << "s : ";
+        std::cout << (std::is_sorted(v_hierarchical.begin(), v_hierarchical.end()) ?
+                "Sorted correctly\n" : "Not sorted\n");
+        print_stats(stats);
         std::cout << std::endl;
     }
 }
@@ -97,7 +139,9 @@ void test_string(const boost::mpi::communicator &comm)
     }
     data.scatter();
 
-    psrs::mpi_vector<std::string> reverse_data(data), case_insensitive_data(data);
+    psrs::mpi_vector<std::string> reverse_data(data), case_insensitive_data(data),
+        streaming_data(data), serialized_data(data);
+    int n = data.total_size();
 
     double elapsed_time = time_sort(data);
     data.gather(0);
@@ -112,6 +156,17 @@ void test_string(const boost::mpi::communicator &comm)
     double case_insensitive_time = time_sort(case_insensitive_data, case_insensitive_cmp);
     case_insensitive_data.gather(0);
 
+    // Exchange in windows of 4096 strings
+    psrs::sort_options streaming_opts;
+    streaming_opts.exchange_window = 4096;
+    double streaming_time = time_sort(streaming_data, std::less<std::string>(), streaming_opts);
+    streaming_data.gather(0);
+
+    // Exchange through Boost.Serialization to compare against the flat string exchange
+    psrs::sort_options serialized_opts;
+    serialized_opts.serialize_strings = true;
+    double serialized_time = time_sort(serialized_data, std::less<std::string>(), serialized_opts);
+    serialized_data.gather(0);
 
     if (!comm.rank()) {
         std::cout << "Test string\n";
@@ -123,11 +178,91 @@ void test_string(const boost::mpi::communicator &comm)
         std::cout << "Case insensitive sort time: " << case_insensitive_time << "s : " <<
             (std::is_sorted(case_insensitive_data.begin(), case_insensitive_data.end(),
                             case_insensitive_cmp) ? "Sorted correctly\n" : "Not sorted\n");
+        std::cout << "Streaming exchange sort time: " << streaming_time << "s : " <<
+            (std::is_sorted(streaming_data.begin(), streaming_data.end()) ?
+                "Sorted correctly\n" : "Not sorted\n");
+        std::cout << "Serialized exchange sort time: " << serialized_time << "s : " <<
+            (std::is_sorted(serialized_data.begin(), serialized_data.end()) ?
+                "Sorted correctly\n" : "Not sorted\n");
+        std::cout << "Throughput (flat / serialized): " << n / elapsed_time << " / " <<
+            n / serialized_time << " strings/s\n";
         std::cout << std::endl;
     }
 }
 
 
+void test_skewed(const boost::mpi::communicator &comm, int N)
+{
+    std::vector<double> data;
+
+    if (!comm.rank()) {
+        std::random_device rd;
+        std::mt19937 engine(rd());
+        std::uniform_real_distribution<double> range(-100.0, 100.0);
+        std::bernoulli_distribution unique(0.1);
+
+        data.resize(N);
+        std::generate(data.begin(), data.end(), [&]()->double {
+            return unique(engine) ? range(engine) : 1.0;
+        });
+    } // Generate data on proc 0. 90% of the values are 1.0
+
+    psrs::mpi_vector<double> v(comm, data.begin(), data.end(), 0);
+    psrs::mpi_vector<double> v_histogram(v);
+
+    double elapsed_time = time_sort(v);
+    double imbalance = psrs::load_imbalance(v);
+
+    boost::mpi::timer rebalance_timer;
+    v.rebalance();
+    double rebalance_time = rebalance_timer.elapsed();
+    double rebalanced_imbalance = psrs::load_imbalance(v);
+    v.gather(0);
+
+    psrs::sort_options histogram_opts;
+    histogram_opts.partition = psrs::partition_mode::histogram;
+    double histogram_time = time_sort(v_histogram, std::less<double>(), histogram_opts);
+    double histogram_imbalance = psrs::load_imbalance(v_histogram);
+    v_histogram.gather(0);
+
+    if (!comm.rank()) {
+        std::cout << "Test skewed double:\n";
+        std::cout << "Regular sampling sort time: " << elapsed_time << "s : " <<
+            (std::is_sorted(v.begin(), v.end()) ? "Sorted correctly" : "Not sorted") <<
+            " : max/avg load " << imbalance << '\n';
+        std::cout << "Rebalance time: " << rebalance_time << "s : max/avg load " <<
+            rebalanced_imbalance << '\n';
+        std::cout << "Histogram sort time: " << histogram_time << "s : " <<
+            (std::is_sorted(v_histogram.begin(), v_histogram.end()) ? "Sorted correctly" :
+             "Not sorted") << " : max/avg load " << histogram_imbalance << '\n';
+        std::cout << std::endl;
+    }
+}
+
+
+void print_stats(const psrs::sort_stats &stats)
+{
+    auto print = [](const std::string &name, const psrs::phase_stat &s) {
+        std::cout << "  " << std::left << std::setw(16) << name << std::right << std::setw(14) <<
+            s.min << std::setw(14) << s.max << std::setw(14) << s.avg << '\n';
+    };
+
+    std::cout << "Phase breakdown:\n  " << std::left << std::setw(16) << "" << std::right <<
+        std::setw(14) << "min" << std::setw(14) << "max" << std::setw(14) << "avg" << '\n';
+    print("local sort", stats.local_sort);
+    print("sampling", stats.sampling);
+    print("broadcast", stats.broadcast);
+    print("partition", stats.partition);
+    print("count exchange", stats.count_exchange);
+    print("data exchange", stats.data_exchange);
+    print("merge", stats.merge);
+    print("total", stats.total);
+    print("bytes sent", stats.bytes_sent);
+    print("bytes received", stats.bytes_received);
+    print("elements", stats.elements);
+}
+
+
 template <typename T>
 double time_sort(psrs::mpi_vector<T> &v)
 {
@@ -146,3 +281,13 @@ double time_sort(psrs::mpi_vector<T> &v, Compare cmp)
 
     return sort_timer.elapsed();
 }
+
+
+template <typename T, class Compare>
+double time_sort(psrs::mpi_vector<T> &v, Compare cmp, const psrs::sort_options &opts)
+{
+    boost::mpi::timer sort_timer;
+    psrs::sort(v, cmp, opts);
+
+    return sort_timer.elapsed();
+}
@@ -6,7 +6,11 @@
 #define MPI_ALLTOALLV
 
 #include <vector>
+#include <string>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
+#include <type_traits>
 #include <mpi.h>
 
 #include <boost/mpi/communicator.hpp>
@@ -14,46 +18,77 @@
 #include <boost/mpi/exception.hpp>
 #include <boost/mpi/collectives.hpp>
 #include <boost/mpi/allocator.hpp>
+#include <boost/mpi/packed_oarchive.hpp>
+#include <boost/mpi/packed_iarchive.hpp>
+
+#include "mpi_utility.h"
+#include "large_count.h"
 
 
 namespace psrs {
 namespace mpi {
 
+
+/* struct: xfer_size
+ *
+ * Number of bytes a proc sent to and received from other procs in an exchange. Data a proc
+ * sends to itself is not counted.
+ */
+struct xfer_size
+{
+    long long sent = 0;
+    long long received = 0;
+};
+
+
 namespace detail {
 
 
 template <typename T>
-void all_to_allv_mpi_type_impl(const boost::mpi::communicator &comm,
+xfer_size all_to_allv_mpi_type_impl(const boost::mpi::communicator &comm,
         const T *in_values, const int *in_count, const int *in_disp,
         T *out_values, const int *out_count, const int *out_disp)
 {
-    MPI_Datatype dtype = boost::mpi::get_mpi_datatype<T>(*in_values);
+    MPI_Datatype dtype = boost::mpi::get_mpi_datatype<T>(T());
     BOOST_MPI_CHECK_RESULT(MPI_Alltoallv,
             (const_cast<T*>(in_values), const_cast<int*>(in_count), const_cast<int*>(in_disp), dtype,
              out_values, const_cast<int*>(out_count), const_cast<int*>(out_disp), dtype, comm));
+
+    xfer_size xfer;
+    for (int i = 0; i < comm.size(); i++) {
+        if (i != comm.rank()) {
+            xfer.sent += static_cast<long long>(in_count[i]) * sizeof(T);
+            xfer.received += static_cast<long long>(out_count[i]) * sizeof(T);
+        }
+    } // Count bytes
+
+    return xfer;
 }
 
 
 template <typename T>
-void all_to_allv_general_impl(const boost::mpi::communicator &comm,
+xfer_size all_to_allv_general_impl(const boost::mpi::communicator &comm,
         const T *in_values, const int *in_count, const int *in_disp,
         T *out_values, const int *out_count, const int *out_disp)
 {
     int p = comm.size();
     int rank = comm.rank();
 
-    // Prepare data to send out
-    std::vector<int> send_count(p), send_disp(p);
-    std::vector<char, boost::mpi::allocator<char> > outgoing;
+    // Prepare data to send out. Boost archives track their position as an int, so every
+    // destination is packed on its own and byte counts are 64 bit.
+    std::vector<long long> send_count(p), send_disp(p);
+    std::vector<char, boost::mpi::allocator<char> > outgoing, block;
 
     int skip = 0;
     for (int dest = 0; dest < p; dest++) {
         send_disp[dest] = outgoing.size();
 
         if (dest != rank) {
-            boost::mpi::packed_oarchive oa(comm, outgoing);
+            block.clear();
+            boost::mpi::packed_oarchive oa(comm, block);
             for (int i = 0; i < in_count[dest]; i++)
                 oa << in_values[skip + i];
+            outgoing.insert(outgoing.end(), block.begin(), block.end());
         } // Pack data if needed
 
         skip += in_count[dest];
@@ -61,10 +96,10 @@ void all_to_allv_general_impl(const boost::mpi::communicator &comm,
     } // Pack outgoing data
 
     // Prepare incoming data
-    std::vector<int> recv_count(p), recv_disp(p);
+    std::vector<long long> recv_count(p), recv_disp(p);
     boost::mpi::all_to_all(comm, send_count, recv_count);
 
-    int sum = 0;
+    long long sum = 0;
     for (int src = 0; src < p; src++) {
         recv_disp[src] = sum;
         sum += recv_count[src];
@@ -72,19 +107,16 @@ void all_to_allv_general_impl(const boost::mpi::communicator &comm,
 
     std::vector<char, boost::mpi::allocator<char> > incoming(sum > 0 ? sum : 1);
 
-    // Incase outgoing vector is empty, put a value
-    if (outgoing.empty())
-        outgoing.push_back(0);
-
     // Perform data swap on the buffers
-    BOOST_MPI_CHECK_RESULT(MPI_Alltoallv, (&outgoing[0], &send_count[0], &send_disp[0],
-                MPI_PACKED, &incoming[0], &recv_count[0], &recv_disp[0], MPI_PACKED, comm));
+    psrs::mpi::large_alltoallv(comm, outgoing.data(), send_count, send_disp, incoming.data(),
+            recv_count, recv_disp, MPI_PACKED);
 
     // Unpack buffer
     for (int proc = 0; proc < p; proc++) {
         if (proc != rank) {
-            boost::mpi::packed_iarchive ia(comm, incoming,
-                    boost::archive::no_header, recv_disp[proc]);
+            block.assign(incoming.begin() + recv_disp[proc],
+                    incoming.begin() + recv_disp[proc] + recv_count[proc]);
+            boost::mpi::packed_iarchive ia(comm, block, boost::archive::no_header);
             for (int i = 0; i < out_count[proc]; i++)
                 ia >> out_values[out_disp[proc] + i];
         } else {
@@ -92,6 +124,211 @@ void all_to_allv_general_impl(const boost::mpi::communicator &comm,
                     out_values + out_disp[proc]);
         } // Unpack data depending on process rank
     } // Loop over proc's data
+
+    xfer_size xfer;
+    xfer.sent = std::accumulate(send_count.begin(), send_count.end(), 0LL);
+    xfer.received = sum;
+
+    return xfer;
+}
+
+
+inline xfer_size all_to_allv_string_impl(const boost::mpi::communicator &comm,
+        const std::string *in_values, const int *in_count, const int *in_disp,
+        std::string *out_values, const int *out_count, const int *out_disp)
+{
+    int p = comm.size();
+
+    // Length of every outgoing string, laid out the same way as in_values. Strings are packed
+    // into one char buffer ordered by destination.
+    int in_size = 0, out_size = 0;
+    for (int i = 0; i < p; i++) {
+        in_size = std::max(in_size, in_disp[i] + in_count[i]);
+        out_size = std::max(out_size, out_disp[i] + out_count[i]);
+    } // Compute extent of input and output
+
+    // Char counts can pass 2^31 even when the string counts do not
+    std::vector<int> send_len(in_size > 0 ? in_size : 1), recv_len(out_size > 0 ? out_size : 1);
+    std::vector<long long> send_chars(p, 0), send_char_disp(p), recv_chars(p, 0),
+        recv_char_disp(p);
+
+    long long total = 0;
+    for (int dest = 0; dest < p; dest++) {
+        send_char_disp[dest] = total;
+        for (int i = in_disp[dest]; i < in_disp[dest] + in_count[dest]; i++) {
+            send_len[i] = in_values[i].size();
+            send_chars[dest] += send_len[i];
+        } // Loop over strings to dest
+        total += send_chars[dest];
+    } // Compute lengths and char counts
+
+    std::vector<char> outgoing(total > 0 ? total : 1);
+    char *pos = outgoing.data();
+    for (int dest = 0; dest < p; dest++)
+        for (int i = in_disp[dest]; i < in_disp[dest] + in_count[dest]; i++)
+            pos = std::copy(in_values[i].begin(), in_values[i].end(), pos);
+
+    // Exchange lengths. Char counts for each proc follow from the lengths received.
+    BOOST_MPI_CHECK_RESULT(MPI_Alltoallv,
+            (send_len.data(), const_cast<int*>(in_count), const_cast<int*>(in_disp), MPI_INT,
+             recv_len.data(), const_cast<int*>(out_count), const_cast<int*>(out_disp), MPI_INT,
+             comm));
+
+    total = 0;
+    for (int src = 0; src < p; src++) {
+        recv_char_disp[src] = total;
+        for (int i = out_disp[src]; i < out_disp[src] + out_count[src]; i++)
+            recv_chars[src] += recv_len[i];
+        total += recv_chars[src];
+    } // Compute incoming char counts
+
+    // Exchange chars
+    std::vector<char> incoming(total > 0 ? total : 1);
+    large_alltoallv(comm, outgoing.data(), send_chars, send_char_disp, incoming.data(),
+            recv_chars, recv_char_disp, MPI_CHAR);
+
+    // Rebuild strings straight from each bucket's chars. Every std::string owns its storage, so
+    // assign() reuses the capacity out_values kept from earlier calls, and short strings need no
+    // allocation at all.
+    for (int src = 0; src < p; src++) {
+        const char *chars = incoming.data() + recv_char_disp[src];
+        for (int i = out_disp[src]; i < out_disp[src] + out_count[src]; i++) {
+            out_values[i].assign(chars, recv_len[i]);
+            chars += recv_len[i];
+        } // Loop over strings from src
+    } // Loop over procs
+
+    xfer_size xfer;
+    for (int i = 0; i < p; i++) {
+        if (i != comm.rank()) {
+            xfer.sent += send_chars[i] + static_cast<long long>(in_count[i]) * sizeof(int);
+            xfer.received += recv_chars[i] + static_cast<long long>(out_count[i]) * sizeof(int);
+        }
+    } // Count bytes
+
+    return xfer;
+}
+
+
+template <typename T>
+xfer_size all_to_allv_streaming_impl(const boost::mpi::communicator &comm,
+        const T *in_values, const int *in_count, const int *in_disp,
+        T *out_values, const int *out_count, const int *out_disp, int window)
+{
+    typedef std::vector<char, boost::mpi::allocator<char> > buffer_type;
+
+    int p = comm.size();
+    int rank = comm.rank();
+
+    // Our own portion does not need to be packed
+    std::copy(in_values + in_disp[rank], in_values + in_disp[rank] + in_count[rank],
+            out_values + out_disp[rank]);
+
+    // Each message holds up to window elements, so the number of messages to expect from every
+    // proc is known from out_count. Messages from a proc arrive in the order they were sent.
+    int recv_left = 0;
+    std::vector<int> recv_done(p, 0);
+    for (int src = 0; src < p; src++)
+        if (src != rank)
+            recv_left += (out_count[src] + window - 1) / window;
+
+    buffer_type incoming;
+    xfer_size xfer;
+
+    // Unpacks one incoming window if one has arrived. Only procs with windows left are probed,
+    // so messages from a later exchange are never consumed. Returns true if a window was unpacked.
+    auto poll_recv = [&]()->bool {
+        for (int k = 1; k < p; k++) {
+            int src = (rank + p - k) % p;
+            if (recv_done[src] == out_count[src])
+                continue;
+
+            int flag;
+            MPI_Status stat;
+            BOOST_MPI_CHECK_RESULT(MPI_Iprobe,
+                    (src, psrs::utility::stream_tag, comm, &flag, &stat));
+            if (!flag)
+                continue;
+
+            int bytes;
+            MPI_Get_count(&stat, MPI_PACKED, &bytes);
+            incoming.resize(bytes > 0 ? bytes : 1);
+            BOOST_MPI_CHECK_RESULT(MPI_Recv, (&incoming[0], bytes, MPI_PACKED, src,
+                        psrs::utility::stream_tag, comm, MPI_STATUS_IGNORE));
+
+            int cnt = std::min(window, out_count[src] - recv_done[src]);
+            boost::mpi::packed_iarchive ia(comm, incoming, boost::archive::no_header);
+            for (int i = 0; i < cnt; i++)
+                ia >> out_values[out_disp[src] + recv_done[src] + i];
+
+            recv_done[src] += cnt;
+            recv_left--;
+            xfer.received += bytes;
+            return true;
+        } // Loop over procs with windows left
+
+        return false;
+    };
+
+    // Double buffer the outgoing windows so the next window is packed while the previous one is
+    // in flight. Incoming windows are drained while waiting on a send to avoid deadlock.
+    buffer_type outgoing[2];
+    MPI_Request reqs[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+    int slot = 0;
+
+    for (int k = 1; k < p; k++) {
+        int dest = (rank + k) % p;
+
+        for (int sent = 0; sent < in_count[dest]; sent += window) {
+            int flag = 0;
+            while (!flag) {
+                BOOST_MPI_CHECK_RESULT(MPI_Test, (&reqs[slot], &flag, MPI_STATUS_IGNORE));
+                if (!flag)
+                    poll_recv();
+            } // Wait for the buffer to be free
+
+            int cnt = std::min(window, in_count[dest] - sent);
+            outgoing[slot].clear();
+            boost::mpi::packed_oarchive oa(comm, outgoing[slot], boost::archive::no_header);
+            for (int i = 0; i < cnt; i++)
+                oa << in_values[in_disp[dest] + sent + i];
+
+            BOOST_MPI_CHECK_RESULT(MPI_Isend, (outgoing[slot].data(), outgoing[slot].size(),
+                        MPI_PACKED, dest, psrs::utility::stream_tag, comm, &reqs[slot]));
+            xfer.sent += outgoing[slot].size();
+            slot = 1 - slot;
+        } // Loop over windows
+    } // Loop over destinations, starting after this proc to spread out the load
+
+    // Finish receiving and wait for outstanding sends
+    while (recv_left > 0)
+        if (!poll_recv())
+            for (int i = 0; i < 2; i++) {
+                int flag;
+                BOOST_MPI_CHECK_RESULT(MPI_Test, (&reqs[i], &flag, MPI_STATUS_IGNORE));
+            } // Progress sends while waiting
+
+    BOOST_MPI_CHECK_RESULT(MPI_Waitall, (2, reqs, MPI_STATUSES_IGNORE));
+
+    return xfer;
+}
+
+
+/* narrow_counts()
+ * @INPUT: v = 64 bit counts or displacements
+ *
+ * Returns v as ints. Throws std::runtime_error if a value does not fit, only types with an
+ * MPI_Datatype can be exchanged with 64 bit counts.
+ */
+inline std::vector<int> narrow_counts(const std::vector<long long> &v)
+{
+    for (long long x : v)
+        if (x > std::numeric_limits<int>::max())
+            throw std::runtime_error("Error: all_to_allv() count " + std::to_string(x) +
+                    " does not fit in an int. Only types with an MPI_Datatype support 64 bit "
+                    "counts.");
+
+    return std::vector<int>(v.begin(), v.end());
 }
 
 
@@ -100,16 +337,19 @@ void all_to_allv_general_impl(const boost::mpi::communicator &comm,
 
 /* all_to_allv()
  * @INPUT: comm = MPI communicator
- * @INPUT: in_values = values to send
+ * @INPUT: in_values = pointer to values to send
  * @INPUT: in_count, in_disp = count and displacement for values to send
  * @INPUT: out_values = output vector
  * @INPUT: out_values, out_count = count and displancement for output vector
  *
  * Wrapper for MPI_Alltoallv. Supports both MPI_Datatype and serializable datatypes using
- * the Boost.Serialization library.
+ * the Boost.Serialization library. std::string is sent as one char buffer and an array of
+ * lengths with two plain MPI_Alltoallv calls. Values are sent directly from in_values, so no copy
+ * of the input is made. out_values is resized to fit the incoming data and keeps its capacity, so
+ * it can be reused as a receive buffer across calls. Returns the number of bytes exchanged.
  */
 template <typename T>
-inline void all_to_allv(const boost::mpi::communicator &comm, const std::vector<T> &in_values,
+inline xfer_size all_to_allv(const boost::mpi::communicator &comm, const T *in_values,
         const std::vector<int> &in_count, const std::vector<int> &in_disp,
         std::vector<T> &out_values, const std::vector<int> &out_count,
         const std::vector<int> &out_disp)
@@ -120,11 +360,158 @@ inline void all_to_allv(const boost::mpi::communicator &comm, const std::vector<
     out_values.resize(out_size);
 
     if constexpr(boost::mpi::is_mpi_datatype<T>())
-        detail::all_to_allv_mpi_type_impl(comm, &in_values[0], in_count.data(), in_disp.data(),
-            &out_values[0], out_count.data(), out_disp.data());
+        return detail::all_to_allv_mpi_type_impl(comm, in_values, in_count.data(), in_disp.data(),
+            out_values.data(), out_count.data(), out_disp.data());
+    else if constexpr(std::is_same_v<T, std::string>)
+        return detail::all_to_allv_string_impl(comm, in_values, in_count.data(), in_disp.data(),
+                out_values.data(), out_count.data(), out_disp.data());
+    else
+        return detail::all_to_allv_general_impl(comm, in_values, in_count.data(), in_disp.data(),
+                out_values.data(), out_count.data(), out_disp.data());
+}
+
+
+/* all_to_allv_serialized()
+ * @INPUT: comm = MPI communicator
+ * @INPUT: in_values = pointer to values to send
+ * @INPUT: in_count, in_disp = count and displacement for values to send
+ * @INPUT: out_values = output vector
+ * @INPUT: out_values, out_count = count and displancement for output vector
+ *
+ * Same as all_to_allv(), but types without an MPI_Datatype always go through
+ * Boost.Serialization. all_to_allv() sends std::string as a flat char buffer plus lengths.
+ */
+template <typename T>
+inline xfer_size all_to_allv_serialized(const boost::mpi::communicator &comm, const T *in_values,
+        const std::vector<int> &in_count, const std::vector<int> &in_disp,
+        std::vector<T> &out_values, const std::vector<int> &out_count,
+        const std::vector<int> &out_disp)
+{
+    if constexpr(boost::mpi::is_mpi_datatype<T>()) {
+        return all_to_allv(comm, in_values, in_count, in_disp, out_values, out_count, out_disp);
+    } else {
+        out_values.resize(std::accumulate(out_count.begin(), out_count.end(), 0));
+        return detail::all_to_allv_general_impl(comm, in_values, in_count.data(), in_disp.data(),
+                out_values.data(), out_count.data(), out_disp.data());
+    }
+}
+
+
+/* all_to_allv()
+ * @INPUT: comm = MPI communicator
+ * @INPUT: in_values = pointer to values to send
+ * @INPUT: in_count, in_disp = count and displacement for values to send
+ * @INPUT: out_values = output vector
+ * @INPUT: out_values, out_count = count and displancement for output vector
+ * @INPUT: window = max number of elements packed into a single message
+ *
+ * Streaming version of all_to_allv() for types without an MPI_Datatype. Instead of packing all
+ * outgoing data into one buffer, elements are packed in windows of at most window elements and
+ * sent with nonblocking point to point messages while the next window is packed and incoming
+ * windows are unpacked. Only two outgoing and one incoming window exist at a time, which bounds
+ * the memory used for serialization. MPI datatypes and window <= 0 use the regular all_to_allv().
+ */
+template <typename T>
+inline xfer_size all_to_allv(const boost::mpi::communicator &comm, const T *in_values,
+        const std::vector<int> &in_count, const std::vector<int> &in_disp,
+        std::vector<T> &out_values, const std::vector<int> &out_count,
+        const std::vector<int> &out_disp, int window)
+{
+    if constexpr(boost::mpi::is_mpi_datatype<T>()) {
+        return all_to_allv(comm, in_values, in_count, in_disp, out_values, out_count, out_disp);
+    } else {
+        if (window <= 0)
+            return all_to_allv(comm, in_values, in_count, in_disp, out_values, out_count,
+                    out_disp);
+
+        out_values.resize(std::accumulate(out_count.begin(), out_count.end(), 0));
+        return detail::all_to_allv_streaming_impl(comm, in_values, in_count.data(), in_disp.data(),
+                out_values.data(), out_count.data(), out_disp.data(), window);
+    }
+}
+
+
+/* all_to_allv()
+ * @INPUT: comm = MPI communicator
+ * @INPUT: in_values = values to send
+ * @INPUT: in_count, in_disp = count and displacement for values to send
+ * @INPUT: out_values = output vector
+ * @INPUT: out_values, out_count = count and displancement for output vector
+ *
+ * Wrapper for MPI_Alltoallv taking the values to send as a vector.
+ */
+template <typename T>
+inline xfer_size all_to_allv(const boost::mpi::communicator &comm, const std::vector<T> &in_values,
+        const std::vector<int> &in_count, const std::vector<int> &in_disp,
+        std::vector<T> &out_values, const std::vector<int> &out_count,
+        const std::vector<int> &out_disp)
+{
+    return all_to_allv(comm, in_values.data(), in_count, in_disp, out_values, out_count,
+            out_disp);
+}
+
+
+/* all_to_allv()
+ * @INPUT: comm = MPI communicator
+ * @INPUT: in_values = pointer to values to send
+ * @INPUT: in_count, in_disp = 64 bit count and displacement for values to send
+ * @INPUT: out_values = output vector
+ * @INPUT: out_count, out_disp = 64 bit count and displacement for output vector
+ * @INPUT: window = max number of elements packed into a single message. Defaults to 0
+ *
+ * all_to_allv() with 64 bit counts and displacements. Types with an MPI_Datatype go through
+ * large_alltoallv(). Other types are serialized into int sized buffers, so their counts are
+ * narrowed to int and the int versions are used.
+ */
+template <typename T>
+inline xfer_size all_to_allv(const boost::mpi::communicator &comm, const T *in_values,
+        const std::vector<long long> &in_count, const std::vector<long long> &in_disp,
+        std::vector<T> &out_values, const std::vector<long long> &out_count,
+        const std::vector<long long> &out_disp, int window = 0)
+{
+    if constexpr(boost::mpi::is_mpi_datatype<T>()) {
+        out_values.resize(std::accumulate(out_count.begin(), out_count.end(), 0LL));
+        large_alltoallv(comm, in_values, in_count, in_disp, out_values.data(), out_count,
+                out_disp, boost::mpi::get_mpi_datatype<T>());
+
+        xfer_size xfer;
+        for (int i = 0; i < comm.size(); i++) {
+            if (i != comm.rank()) {
+                xfer.sent += in_count[i] * static_cast<long long>(sizeof(T));
+                xfer.received += out_count[i] * static_cast<long long>(sizeof(T));
+            }
+        } // Count bytes
+
+        return xfer;
+    } else {
+        return all_to_allv(comm, in_values, detail::narrow_counts(in_count),
+                detail::narrow_counts(in_disp), out_values, detail::narrow_counts(out_count),
+                detail::narrow_counts(out_disp), window);
+    }
+}
+
+
+/* all_to_allv_serialized()
+ * @INPUT: comm = MPI communicator
+ * @INPUT: in_values = pointer to values to send
+ * @INPUT: in_count, in_disp = 64 bit count and displacement for values to send
+ * @INPUT: out_values = output vector
+ * @INPUT: out_count, out_disp = 64 bit count and displacement for output vector
+ *
+ * all_to_allv_serialized() with 64 bit counts and displacements.
+ */
+template <typename T>
+inline xfer_size all_to_allv_serialized(const boost::mpi::communicator &comm, const T *in_values,
+        const std::vector<long long> &in_count, const std::vector<long long> &in_disp,
+        std::vector<T> &out_values, const std::vector<long long> &out_count,
+        const std::vector<long long> &out_disp)
+{
+    if constexpr(boost::mpi::is_mpi_datatype<T>())
+        return all_to_allv(comm, in_values, in_count, in_disp, out_values, out_count, out_disp);
     else
-        detail::all_to_allv_general_impl(comm, &in_values[0], in_count.data(), in_disp.data(),
-                &out_values[0], out_count.data(), out_disp.data());
+        return all_to_allv_serialized(comm, in_values, detail::narrow_counts(in_count),
+                detail::narrow_counts(in_disp), out_values, detail::narrow_counts(out_count),
+                detail::narrow_counts(out_disp));
 }
 
 
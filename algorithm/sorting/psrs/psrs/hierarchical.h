@@ -0,0 +1,351 @@
+/* Written by: Eric Tan
+ *
+ * Two level, node aware all to all exchange. Data is first gathered to one leader per node, the
+ * leaders exchange everything between nodes, and each leader scatters the result within its node.
+ * A flat MPI_Alltoallv sends up to p^2 messages; this sends about p within nodes and one per
+ * pair of nodes between them. Nodes come from MPI_Comm_split_type(MPI_COMM_TYPE_SHARED), or can
+ * be emulated with a fixed number of ranks per group to test on a single machine.
+ */
+#ifndef HIERARCHICAL_H
+#define HIERARCHICAL_H
+
+#include <vector>
+#include <map>
+#include <numeric>
+#include <algorithm>
+#include <mpi.h>
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/datatype.hpp>
+#include <boost/mpi/exception.hpp>
+#include <boost/mpi/collectives.hpp>
+
+#include "all_to_allv.h"
+#include "large_count.h"
+
+
+namespace psrs {
+namespace mpi {
+
+
+/* struct: node_topology
+ *
+ * node = communicator of the procs sharing this proc's node
+ * leaders = communicator of every node's rank 0. Null on other procs
+ * node_of[q], pos_of[q] = node index and rank within that node of global rank q
+ * members[g] = global ranks in node g, in node rank order
+ */
+struct node_topology
+{
+    boost::mpi::communicator node;
+    boost::mpi::communicator leaders;
+    std::vector<int> node_of;
+    std::vector<int> pos_of;
+    std::vector<std::vector<int> > members;
+};
+
+
+/* make_node_topology()
+ * @INPUT: comm = communicator
+ * @INPUT: ranks_per_group = emulated node size. <= 0 uses the real shared memory nodes
+ *
+ * Splits comm into nodes and node leaders. With ranks_per_group > 0, ranks
+ * [k * ranks_per_group, (k + 1) * ranks_per_group) form node k.
+ */
+inline node_topology make_node_topology(const boost::mpi::communicator &comm,
+        int ranks_per_group)
+{
+    node_topology topo;
+    int id = comm.rank();
+
+    if (ranks_per_group > 0) {
+        topo.node = comm.split(id / ranks_per_group, id);
+    } else {
+        MPI_Comm node_comm;
+        BOOST_MPI_CHECK_RESULT(MPI_Comm_split_type, (comm, MPI_COMM_TYPE_SHARED, id,
+                    MPI_INFO_NULL, &node_comm));
+        topo.node = boost::mpi::communicator(node_comm, boost::mpi::comm_take_ownership);
+    } // Emulated or real nodes
+
+    bool is_leader = topo.node.rank() == 0;
+    topo.leaders = comm.split(is_leader ? 0 : MPI_UNDEFINED, id);
+
+    // Every proc learns the node index of every rank
+    int node_id = is_leader ? topo.leaders.rank() : 0;
+    boost::mpi::broadcast(topo.node, node_id, 0);
+
+    int local[2] = {node_id, topo.node.rank()};
+    std::vector<int> all(2 * comm.size());
+    BOOST_MPI_CHECK_RESULT(MPI_Allgather, (local, 2, MPI_INT, all.data(), 2, MPI_INT, comm));
+
+    int nodes = 0;
+    topo.node_of.resize(comm.size());
+    topo.pos_of.resize(comm.size());
+    for (int q = 0; q < comm.size(); q++) {
+        topo.node_of[q] = all[2 * q];
+        topo.pos_of[q] = all[2 * q + 1];
+        nodes = std::max(nodes, topo.node_of[q] + 1);
+    } // Loop over ranks
+
+    topo.members.resize(nodes);
+    for (int q = 0; q < comm.size(); q++) {
+        auto &m = topo.members[topo.node_of[q]];
+        m.resize(std::max<int>(m.size(), topo.pos_of[q] + 1));
+        m[topo.pos_of[q]] = q;
+    } // Loop over ranks
+
+    return topo;
+}
+
+
+namespace detail {
+
+
+/* topology_keyval()
+ *
+ * Attribute key of the node topologies cached on a communicator. The attribute maps
+ * ranks_per_group to a topology and is deleted along with the communicator.
+ */
+inline int topology_keyval()
+{
+    static int keyval = [] {
+        int key;
+        auto del = [](MPI_Comm, int, void *attr, void *) -> int {
+            delete static_cast<std::map<int, node_topology>*>(attr);
+            return MPI_SUCCESS;
+        };
+        BOOST_MPI_CHECK_RESULT(MPI_Comm_create_keyval, (MPI_COMM_NULL_COPY_FN, del, &key,
+                    nullptr));
+        return key;
+    }();
+
+    return keyval;
+}
+
+
+/* is_packed()
+ * @INPUT: count, disp = counts and displacements
+ *
+ * True if every block starts right after the one before it.
+ */
+inline bool is_packed(const std::vector<long long> &count, const std::vector<long long> &disp)
+{
+    for (std::size_t i = 0, offset = 0; i < count.size(); offset += count[i], i++)
+        if (disp[i] != static_cast<long long>(offset))
+            return false;
+
+    return true;
+}
+
+
+}; // namespace detail
+
+
+/* cached_node_topology()
+ * @INPUT: comm = communicator
+ * @INPUT: ranks_per_group = emulated node size. <= 0 uses the real shared memory nodes
+ *
+ * Same as make_node_topology(), but the topology is built once per communicator and group size
+ * and kept as an attribute of comm. Collective the first time it is called for a group size.
+ */
+inline const node_topology &cached_node_topology(const boost::mpi::communicator &comm,
+        int ranks_per_group)
+{
+    typedef std::map<int, node_topology> cache_type;
+    int key = detail::topology_keyval();
+    void *attr;
+    int found;
+    cache_type *cache;
+
+    BOOST_MPI_CHECK_RESULT(MPI_Comm_get_attr, (comm, key, &attr, &found));
+    if (found) {
+        cache = static_cast<cache_type*>(attr);
+    } else {
+        cache = new cache_type;
+        BOOST_MPI_CHECK_RESULT(MPI_Comm_set_attr, (comm, key, cache));
+    }
+
+    ranks_per_group = std::max(ranks_per_group, 0);
+    auto it = cache->find(ranks_per_group);
+    if (it == cache->end())
+        it = cache->emplace(ranks_per_group, make_node_topology(comm, ranks_per_group)).first;
+
+    return it->second;
+}
+
+
+/* all_to_allv_hierarchical()
+ * @INPUT: comm = MPI communicator
+ * @INPUT: topo = node topology of comm
+ * @INPUT: in_values = pointer to values to send
+ * @INPUT: in_count, in_disp = count and displacement for values to send
+ * @INPUT: out_values = output vector
+ * @INPUT: out_count, out_disp = count and displacement for output vector
+ *
+ * Same result as all_to_allv() for types with an MPI_Datatype, in three steps:
+ *  1. Every proc sends its counts and data to its node leader with MPI_Gather(v).
+ *  2. Leaders regroup the data by destination node and swap it with one MPI_Alltoallv. Leaders
+ *     also gather their members' receive counts, so no extra count exchange is needed.
+ *  3. Leaders order each member's data by source rank and MPI_Scatterv it back out.
+ * Each copy is released once the next one is built, so leaders hold at most two copies of their
+ * node's data at a time. Counts are 64 bit and every step goes through the large count
+ * collectives.
+ */
+template <typename T>
+xfer_size all_to_allv_hierarchical(const boost::mpi::communicator &comm,
+        const node_topology &topo, const T *in_values, const std::vector<long long> &in_count,
+        const std::vector<long long> &in_disp, std::vector<T> &out_values,
+        const std::vector<long long> &out_count, const std::vector<long long> &out_disp)
+{
+    static_assert(boost::mpi::is_mpi_datatype<T>::value,
+            "all_to_allv_hierarchical() needs a type with an MPI_Datatype");
+
+    MPI_Datatype dtype = boost::mpi::get_mpi_datatype<T>();
+    const boost::mpi::communicator &node = topo.node;
+    int p = comm.size();
+    int m = node.size();
+    int nodes = topo.members.size();
+    bool is_leader = node.rank() == 0;
+
+    // Pack outgoing data in destination order if it is not already
+    std::vector<T> packed;
+    const T *send = in_values;
+    long long send_n = std::accumulate(in_count.begin(), in_count.end(), 0LL);
+    if (!detail::is_packed(in_count, in_disp)) {
+        packed.reserve(send_n);
+        for (int q = 0; q < p; q++)
+            packed.insert(packed.end(), in_values + in_disp[q], in_values + in_disp[q] + in_count[q]);
+        send = packed.data();
+    }
+
+    // Step 1: counts and data to the leader. cnt[s * p + q] is member s's count to rank q.
+    std::vector<long long> send_cnt, recv_cnt, member_n, member_off;
+    if (is_leader) {
+        send_cnt.resize(m * p);
+        recv_cnt.resize(m * p);
+        member_n.resize(m);
+        member_off.assign(m, 0);
+    }
+
+    BOOST_MPI_CHECK_RESULT(MPI_Gather, (const_cast<long long*>(in_count.data()), p,
+                MPI_LONG_LONG, send_cnt.data(), p, MPI_LONG_LONG, 0, node));
+    BOOST_MPI_CHECK_RESULT(MPI_Gather, (const_cast<long long*>(out_count.data()), p,
+                MPI_LONG_LONG, recv_cnt.data(), p, MPI_LONG_LONG, 0, node));
+
+    std::vector<T> gathered;
+    if (is_leader) {
+        for (int s = 0; s < m; s++)
+            member_n[s] = std::accumulate(send_cnt.begin() + s * p,
+                    send_cnt.begin() + (s + 1) * p, 0LL);
+        std::partial_sum(member_n.begin(), member_n.end() - 1, member_off.begin() + 1);
+        gathered.resize(member_off.back() + member_n.back());
+    }
+
+    large_gatherv(node, send, send_n, gathered.data(), member_n, member_off, dtype, 0);
+    std::vector<T>().swap(packed);
+
+    // Step 2: leaders swap data between nodes
+    std::vector<T> incoming;
+    std::vector<long long> node_recv_cnt(nodes, 0), node_recv_disp(nodes, 0);
+    if (is_leader) {
+        // Start of every (member, destination) block in gathered
+        std::vector<long long> block(m * p);
+        for (int s = 0; s < m; s++) {
+            block[s * p] = member_off[s];
+            for (int q = 1; q < p; q++)
+                block[s * p + q] = block[s * p + q - 1] + send_cnt[s * p + q - 1];
+        } // Loop over members
+
+        // Outgoing data grouped by destination node, then destination member, then source member
+        std::vector<T> outgoing;
+        std::vector<long long> node_send_cnt(nodes, 0), node_send_disp(nodes, 0);
+        outgoing.reserve(gathered.size());
+        for (int h = 0; h < nodes; h++) {
+            node_send_disp[h] = outgoing.size();
+            for (int r : topo.members[h])
+                for (int s = 0; s < m; s++)
+                    outgoing.insert(outgoing.end(), gathered.begin() + block[s * p + r],
+                            gathered.begin() + block[s * p + r] + send_cnt[s * p + r]);
+            node_send_cnt[h] = outgoing.size() - node_send_disp[h];
+        } // Loop over destination nodes
+        std::vector<T>().swap(gathered);
+
+        // Incoming sizes follow from the members' receive counts
+        for (int g = 0; g < nodes; g++) {
+            for (int r = 0; r < m; r++)
+                for (int q : topo.members[g])
+                    node_recv_cnt[g] += recv_cnt[r * p + q];
+            if (g)
+                node_recv_disp[g] = node_recv_disp[g - 1] + node_recv_cnt[g - 1];
+        } // Loop over source nodes
+
+        incoming.resize(node_recv_disp.back() + node_recv_cnt.back());
+        large_alltoallv(topo.leaders, outgoing.data(), node_send_cnt, node_send_disp,
+                incoming.data(), node_recv_cnt, node_recv_disp, dtype);
+    }
+
+    // Step 3: order every member's data by source rank and scatter it
+    std::vector<T> scatter_buf;
+    std::vector<long long> scatter_cnt, scatter_disp;
+    if (is_leader) {
+        // Start of every (destination member, source rank) block in incoming
+        std::vector<long long> block(m * p);
+        for (int g = 0; g < nodes; g++) {
+            long long offset = node_recv_disp[g];
+            for (int r = 0; r < m; r++) {
+                for (int q : topo.members[g]) {
+                    block[r * p + q] = offset;
+                    offset += recv_cnt[r * p + q];
+                }
+            }
+        } // Loop over source nodes
+
+        scatter_cnt.assign(m, 0);
+        scatter_disp.assign(m, 0);
+        scatter_buf.reserve(incoming.size());
+        for (int r = 0; r < m; r++) {
+            scatter_disp[r] = scatter_buf.size();
+            for (int q = 0; q < p; q++)
+                scatter_buf.insert(scatter_buf.end(), incoming.begin() + block[r * p + q],
+                        incoming.begin() + block[r * p + q] + recv_cnt[r * p + q]);
+            scatter_cnt[r] = scatter_buf.size() - scatter_disp[r];
+        } // Loop over members
+        std::vector<T>().swap(incoming);
+    }
+
+    // Displacements may leave gaps, so size the output to the end of the last block
+    long long out_size = std::accumulate(out_count.begin(), out_count.end(), 0LL);
+    long long out_end = out_size;
+    for (int q = 0; q < p; q++)
+        out_end = std::max(out_end, out_disp[q] + out_count[q]);
+    out_values.resize(out_end);
+
+    if (detail::is_packed(out_count, out_disp)) {
+        large_scatterv(node, scatter_buf.data(), scatter_cnt, scatter_disp, out_values.data(),
+                out_size, dtype, 0);
+    } else {
+        std::vector<T> tmp(out_size);
+        large_scatterv(node, scatter_buf.data(), scatter_cnt, scatter_disp, tmp.data(), out_size,
+                dtype, 0);
+        for (long long q = 0, offset = 0; q < p; offset += out_count[q], q++)
+            std::copy(tmp.begin() + offset, tmp.begin() + offset + out_count[q],
+                    out_values.begin() + out_disp[q]);
+    } // Receive in place when the output is packed
+
+    xfer_size xfer;
+    for (int q = 0; q < p; q++) {
+        if (q != comm.rank()) {
+            xfer.sent += in_count[q] * static_cast<long long>(sizeof(T));
+            xfer.received += out_count[q] * static_cast<long long>(sizeof(T));
+        }
+    } // Count bytes
+
+    return xfer;
+}
+
+
+}; // namespace mpi
+}; // namespace psrs
+
+
+#endif
@@ -0,0 +1,151 @@
+/* Written by: Eric Tan
+ *
+ * Histogram based splitter refinement for psrs::sort. Instead of picking pivots from one round of
+ * regular samples, candidate splitters are ranked globally and refined until every bucket is close
+ * to n / p elements. Elements are ordered by (value, rank, index), so duplicate values can be split
+ * between procs.
+ */
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/collectives.hpp>
+
+#include "mpi_vector.h"
+
+
+namespace psrs {
+namespace detail {
+
+
+// Number of candidates each proc offers per unresolved splitter in every round
+constexpr int histogram_samples = 2;
+
+
+/* histogram_partition()
+ * @INPUT: comm = communicator
+ * @INPUT: data = locally sorted data
+ * @INPUT: cmp = comparator
+ * @INPUT: disp = output send displacements, must hold p elements
+ * @INPUT: tolerance = allowed deviation from n / p per bucket, as a fraction of n / p
+ * @INPUT: max_rounds = max number of refinement rounds
+ *
+ * Finds the local split positions for p - 1 splitters with global ranks j * n / p. Each round,
+ * every proc offers elements from the interval that still brackets every unresolved splitter. The
+ * global rank of every candidate is computed with one all_reduce, and the bracketing intervals are
+ * narrowed to the closest candidates on either side. A splitter is resolved once a candidate is
+ * within tolerance of its target. Any splitter left after max_rounds uses the closer bound.
+ */
+template <typename T, class Compare>
+void histogram_partition(const boost::mpi::communicator &comm, const psrs::mpi_vector<T> &data,
+        Compare cmp, std::vector<long long> &disp, double tolerance,
+        int max_rounds)
+{
+    int p = comm.size();
+    int rank = comm.rank();
+    long long local_n = data.size();
+    long long n;
+
+    boost::mpi::all_reduce(comm, local_n, n, std::plus<long long>());
+
+    long long tol = static_cast<long long>(tolerance * n / p);
+    std::vector<long long> target(p - 1), lo_global(p - 1, 0), hi_global(p - 1, n);
+    std::vector<long long> lo(p - 1, 0), hi(p - 1, local_n), pos(p - 1, -1);
+
+    for (int j = 0; j < p - 1; j++)
+        target[j] = (j + 1) * n / p;
+
+    for (int round = 0; round < max_rounds; round++) {
+        // Offer evenly spaced elements from each unresolved interval
+        std::vector<T> vals;
+        std::vector<long long> info; // (splitter, local index) pairs
+
+        for (int j = 0; j < p - 1; j++) {
+            long long len = hi[j] - lo[j];
+            if (pos[j] >= 0 || len <= 0)
+                continue;
+
+            for (int s = 0; s < histogram_samples && s < len; s++) {
+                long long idx = lo[j] + (2 * s + 1) * len / (2 * histogram_samples);
+                vals.push_back(data[idx]);
+                info.push_back(j);
+                info.push_back(idx);
+            }
+        } // Loop over splitters
+
+        std::vector<std::vector<T> > all_vals;
+        std::vector<std::vector<long long> > all_info;
+        boost::mpi::all_gather(comm, vals, all_vals);
+        boost::mpi::all_gather(comm, info, all_info);
+
+        // Local rank of every candidate under (value, rank, index) ordering
+        std::vector<long long> local_rank, global_rank;
+        for (int src = 0; src < p; src++) {
+            for (std::size_t c = 0; c < all_vals[src].size(); c++) {
+                const T &v = all_vals[src][c];
+                long long idx = all_info[src][2 * c + 1];
+                auto lb = std::lower_bound(data.begin(), data.end(), v, cmp);
+                long long cnt = std::distance(data.begin(), lb);
+
+                if (rank < src)
+                    cnt = std::distance(data.begin(), std::upper_bound(lb, data.end(), v, cmp));
+                else if (rank == src)
+                    cnt = idx;
+
+                local_rank.push_back(cnt);
+            }
+        } // Loop over candidates
+
+        if (local_rank.empty())
+            break;
+
+        global_rank.resize(local_rank.size());
+        boost::mpi::all_reduce(comm, local_rank.data(), local_rank.size(), global_rank.data(),
+                std::plus<long long>());
+
+        // Narrow each splitter's interval
+        for (int src = 0, c = 0; src < p; src++) {
+            for (std::size_t k = 0; k < all_vals[src].size(); k++, c++) {
+                int j = all_info[src][2 * k];
+                long long g = global_rank[c];
+
+                if (pos[j] >= 0)
+                    continue;
+
+                if (std::llabs(g - target[j]) <= tol) {
+                    pos[j] = local_rank[c];
+                } else if (g < target[j] && g > lo_global[j]) {
+                    lo_global[j] = g;
+                    lo[j] = local_rank[c];
+                } else if (g > target[j] && g < hi_global[j]) {
+                    hi_global[j] = g;
+                    hi[j] = local_rank[c];
+                }
+            }
+        } // Loop over candidates
+
+        if (std::none_of(pos.begin(), pos.end(), [](long long x) { return x < 0; }))
+            break;
+    } // Refinement rounds
+
+    // Resolve what is left with the closer bound. Positions must not decrease.
+    disp.front() = 0;
+    for (int j = 0; j < p - 1; j++) {
+        if (pos[j] < 0)
+            pos[j] = (target[j] - lo_global[j] <= hi_global[j] - target[j]) ? lo[j] : hi[j];
+
+        disp[j + 1] = std::max(disp[j], pos[j]);
+    } // Loop over splitters
+}
+
+
+}; // namespace detail
+}; // namespace psrs
+
+
+#endif
@@ -0,0 +1,374 @@
+/* Written by: Eric Tan
+ *
+ * Collectives with 64 bit counts and displacements. MPI-4 libraries get the large count (_c)
+ * versions of MPI_Alltoallv, MPI_Gatherv and MPI_Scatterv. Older libraries use the plain int
+ * versions while everything fits, and otherwise send every block as one element of a derived
+ * datatype built from chunks of at most large_count_limit elements.
+ */
+#ifndef LARGE_COUNT_H
+#define LARGE_COUNT_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <mpi.h>
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/exception.hpp>
+
+#include "mpi_utility.h"
+
+
+namespace psrs {
+namespace mpi {
+
+
+// Largest count passed to an int based MPI call. Lower it to run the large count paths on small
+// inputs.
+inline long long large_count_limit = std::numeric_limits<int>::max();
+
+
+/* make_large_type()
+ * @INPUT: count = number of elements
+ * @INPUT: type = element type
+ *
+ * Returns a committed datatype of count contiguous elements of type, which the caller frees. Counts
+ * above large_count_limit are built from large_count_limit element chunks plus a remainder placed
+ * at its byte offset.
+ */
+inline MPI_Datatype make_large_type(long long count, MPI_Datatype type)
+{
+    MPI_Datatype result;
+
+    if (count <= large_count_limit) {
+        BOOST_MPI_CHECK_RESULT(MPI_Type_contiguous, (static_cast<int>(count), type, &result));
+    } else {
+        MPI_Aint lb, extent;
+        MPI_Datatype chunk, chunks, rest;
+        long long rem = count % large_count_limit;
+
+        BOOST_MPI_CHECK_RESULT(MPI_Type_get_extent, (type, &lb, &extent));
+        BOOST_MPI_CHECK_RESULT(MPI_Type_contiguous, (static_cast<int>(large_count_limit), type,
+                    &chunk));
+        chunks = make_large_type(count / large_count_limit, chunk);
+        BOOST_MPI_CHECK_RESULT(MPI_Type_contiguous, (static_cast<int>(rem), type, &rest));
+
+        int len[2] = {1, 1};
+        MPI_Aint disp[2] = {0, static_cast<MPI_Aint>((count - rem) * extent)};
+        MPI_Datatype parts[2] = {chunks, rest};
+        BOOST_MPI_CHECK_RESULT(MPI_Type_create_struct, (2, len, disp, parts, &result));
+
+        MPI_Type_free(&chunk);
+        MPI_Type_free(&chunks);
+        MPI_Type_free(&rest);
+    } // Split into chunks that fit in an int
+
+    BOOST_MPI_CHECK_RESULT(MPI_Type_commit, (&result));
+    return result;
+}
+
+
+/* large_isend(), large_irecv()
+ * @INPUT: buf = data
+ * @INPUT: count = number of elements
+ * @INPUT: type = element type
+ * @INPUT: peer, tag, comm = message envelope
+ * @INPUT: req = output request
+ *
+ * MPI_Isend and MPI_Irecv of any count. Large counts go as one element of make_large_type(). The
+ * datatype is freed right away, MPI keeps it alive until the request completes.
+ */
+inline void large_isend(const void *buf, long long count, MPI_Datatype type, int peer, int tag,
+        MPI_Comm comm, MPI_Request *req)
+{
+    if (count <= large_count_limit) {
+        BOOST_MPI_CHECK_RESULT(MPI_Isend, (const_cast<void*>(buf), static_cast<int>(count), type,
+                    peer, tag, comm, req));
+    } else {
+        MPI_Datatype big = make_large_type(count, type);
+        BOOST_MPI_CHECK_RESULT(MPI_Isend, (const_cast<void*>(buf), 1, big, peer, tag, comm, req));
+        MPI_Type_free(&big);
+    } // One element of a large type
+}
+
+
+inline void large_irecv(void *buf, long long count, MPI_Datatype type, int peer, int tag,
+        MPI_Comm comm, MPI_Request *req)
+{
+    if (count <= large_count_limit) {
+        BOOST_MPI_CHECK_RESULT(MPI_Irecv, (buf, static_cast<int>(count), type, peer, tag, comm,
+                    req));
+    } else {
+        MPI_Datatype big = make_large_type(count, type);
+        BOOST_MPI_CHECK_RESULT(MPI_Irecv, (buf, 1, big, peer, tag, comm, req));
+        MPI_Type_free(&big);
+    } // One element of a large type
+}
+
+
+/* large_send(), large_recv()
+ * @INPUT: comm = communicator
+ * @INPUT: peer = destination or source rank
+ * @INPUT: tag = message tag
+ * @INPUT: values, n = values to send or receive into and their count
+ *
+ * communicator::send() and recv() of serialized values with a 64 bit count. Values go in
+ * messages of at most large_count_limit elements, which MPI delivers in order.
+ */
+template <typename T>
+void large_send(const boost::mpi::communicator &comm, int peer, int tag, const T *values,
+        long long n)
+{
+    for (long long i = 0; i < n; i += large_count_limit)
+        comm.send(peer, tag, values + i, static_cast<int>(std::min(n - i, large_count_limit)));
+}
+
+
+template <typename T>
+void large_recv(const boost::mpi::communicator &comm, int peer, int tag, T *values, long long n)
+{
+    for (long long i = 0; i < n; i += large_count_limit)
+        comm.recv(peer, tag, values + i, static_cast<int>(std::min(n - i, large_count_limit)));
+}
+
+
+namespace detail {
+
+
+/* fits_int()
+ * @INPUT: count, disp = counts and displacements, may be empty
+ *
+ * True if every count and displacement is at most large_count_limit.
+ */
+inline bool fits_int(const std::vector<long long> &count, const std::vector<long long> &disp)
+{
+    for (std::size_t i = 0; i < count.size(); i++)
+        if (count[i] > large_count_limit || disp[i] > large_count_limit)
+            return false;
+
+    return true;
+}
+
+
+/* any_large()
+ * @INPUT: comm = communicator
+ * @INPUT: local = this proc needs the large path
+ *
+ * Every proc has to take the same path, so the procs agree with one MPI_Allreduce.
+ */
+inline bool any_large(const boost::mpi::communicator &comm, bool local)
+{
+    int flag = local, any;
+    BOOST_MPI_CHECK_RESULT(MPI_Allreduce, (&flag, &any, 1, MPI_INT, MPI_LOR, comm));
+    return any;
+}
+
+
+}; // namespace detail
+
+
+/* large_alltoallv()
+ * @INPUT: comm = communicator
+ * @INPUT: in_values = data to send
+ * @INPUT: in_count, in_disp = count and displacement of every outgoing block
+ * @INPUT: out_values = receive buffer, big enough for every incoming block
+ * @INPUT: out_count, out_disp = count and displacement of every incoming block
+ * @INPUT: type = element type
+ *
+ * MPI_Alltoallv with 64 bit counts and displacements. Without MPI-4 the large path posts one
+ * large_isend() and large_irecv() per proc and copies the local block.
+ */
+inline void large_alltoallv(const boost::mpi::communicator &comm, const void *in_values,
+        const std::vector<long long> &in_count, const std::vector<long long> &in_disp,
+        void *out_values, const std::vector<long long> &out_count,
+        const std::vector<long long> &out_disp, MPI_Datatype type)
+{
+    int p = comm.size();
+
+#if MPI_VERSION >= 4
+    std::vector<MPI_Count> sc(in_count.begin(), in_count.end());
+    std::vector<MPI_Count> rc(out_count.begin(), out_count.end());
+    std::vector<MPI_Aint> sd(in_disp.begin(), in_disp.end());
+    std::vector<MPI_Aint> rd(out_disp.begin(), out_disp.end());
+    BOOST_MPI_CHECK_RESULT(MPI_Alltoallv_c, (in_values, sc.data(), sd.data(), type, out_values,
+                rc.data(), rd.data(), type, comm));
+#else
+    bool large = !detail::fits_int(in_count, in_disp) || !detail::fits_int(out_count, out_disp);
+
+    if (!detail::any_large(comm, large)) {
+        std::vector<int> sc(in_count.begin(), in_count.end());
+        std::vector<int> sd(in_disp.begin(), in_disp.end());
+        std::vector<int> rc(out_count.begin(), out_count.end());
+        std::vector<int> rd(out_disp.begin(), out_disp.end());
+        BOOST_MPI_CHECK_RESULT(MPI_Alltoallv, (const_cast<void*>(in_values), sc.data(),
+                    sd.data(), type, out_values, rc.data(), rd.data(), type, comm));
+        return;
+    } // Everything fits in an int
+
+    MPI_Aint lb, extent;
+    BOOST_MPI_CHECK_RESULT(MPI_Type_get_extent, (type, &lb, &extent));
+
+    const char *in = static_cast<const char*>(in_values);
+    char *out = static_cast<char*>(out_values);
+    int id = comm.rank();
+    std::vector<MPI_Request> reqs;
+
+    for (int i = 1; i < p; i++) {
+        int src = (id - i + p) % p;
+        int dest = (id + i) % p;
+
+        if (out_count[src]) {
+            reqs.emplace_back();
+            large_irecv(out + out_disp[src] * extent, out_count[src], type, src,
+                    utility::data_tag, comm, &reqs.back());
+        }
+        if (in_count[dest]) {
+            reqs.emplace_back();
+            large_isend(in + in_disp[dest] * extent, in_count[dest], type, dest,
+                    utility::data_tag, comm, &reqs.back());
+        }
+    } // Loop over procs
+
+    std::copy(in + in_disp[id] * extent, in + (in_disp[id] + in_count[id]) * extent,
+            out + out_disp[id] * extent);
+    BOOST_MPI_CHECK_RESULT(MPI_Waitall, (static_cast<int>(reqs.size()), reqs.data(),
+                MPI_STATUSES_IGNORE));
+#endif
+}
+
+
+/* large_gatherv()
+ * @INPUT: comm = communicator
+ * @INPUT: in_values = data to send, nullptr on root if its block is already in place
+ * @INPUT: in_count = number of elements to send
+ * @INPUT: out_values = receive buffer on root
+ * @INPUT: out_count, out_disp = count and displacement of every block, only used on root
+ * @INPUT: type = element type
+ * @INPUT: root = receiving proc
+ *
+ * MPI_Gatherv with 64 bit counts and displacements.
+ */
+inline void large_gatherv(const boost::mpi::communicator &comm, const void *in_values,
+        long long in_count, void *out_values, const std::vector<long long> &out_count,
+        const std::vector<long long> &out_disp, MPI_Datatype type, int root)
+{
+    int id = comm.rank();
+    bool in_place = id == root && !in_values;
+    const void *send = in_place ? MPI_IN_PLACE : in_values;
+
+#if MPI_VERSION >= 4
+    std::vector<MPI_Count> rc(out_count.begin(), out_count.end());
+    std::vector<MPI_Aint> rd(out_disp.begin(), out_disp.end());
+    BOOST_MPI_CHECK_RESULT(MPI_Gatherv_c, (send, in_count, type, out_values, rc.data(),
+                rd.data(), type, root, comm));
+#else
+    bool large = in_count > large_count_limit || !detail::fits_int(out_count, out_disp);
+
+    if (!detail::any_large(comm, large)) {
+        std::vector<int> rc(out_count.begin(), out_count.end());
+        std::vector<int> rd(out_disp.begin(), out_disp.end());
+        BOOST_MPI_CHECK_RESULT(MPI_Gatherv, (const_cast<void*>(send),
+                    static_cast<int>(in_count), type, out_values, rc.data(), rd.data(), type,
+                    root, comm));
+        return;
+    } // Everything fits in an int
+
+    MPI_Aint lb, extent;
+    BOOST_MPI_CHECK_RESULT(MPI_Type_get_extent, (type, &lb, &extent));
+
+    std::vector<MPI_Request> reqs;
+    if (id == root) {
+        char *out = static_cast<char*>(out_values);
+        for (int i = 0; i < comm.size(); i++) {
+            if (i != root && out_count[i]) {
+                reqs.emplace_back();
+                large_irecv(out + out_disp[i] * extent, out_count[i], type, i, utility::data_tag,
+                        comm, &reqs.back());
+            }
+        } // Loop over procs
+
+        if (!in_place)
+            std::copy(static_cast<const char*>(in_values),
+                    static_cast<const char*>(in_values) + in_count * extent,
+                    out + out_disp[root] * extent);
+    } else if (in_count) {
+        reqs.emplace_back();
+        large_isend(in_values, in_count, type, root, utility::data_tag, comm, &reqs.back());
+    } // Root receives every block
+
+    BOOST_MPI_CHECK_RESULT(MPI_Waitall, (static_cast<int>(reqs.size()), reqs.data(),
+                MPI_STATUSES_IGNORE));
+#endif
+}
+
+
+/* large_scatterv()
+ * @INPUT: comm = communicator
+ * @INPUT: in_values = data to send on root
+ * @INPUT: in_count, in_disp = count and displacement of every block, only used on root
+ * @INPUT: out_values = receive buffer, nullptr on root to leave its block in place
+ * @INPUT: out_count = number of elements to receive
+ * @INPUT: type = element type
+ * @INPUT: root = sending proc
+ *
+ * MPI_Scatterv with 64 bit counts and displacements.
+ */
+inline void large_scatterv(const boost::mpi::communicator &comm, const void *in_values,
+        const std::vector<long long> &in_count, const std::vector<long long> &in_disp,
+        void *out_values, long long out_count, MPI_Datatype type, int root)
+{
+    int id = comm.rank();
+    bool in_place = id == root && !out_values;
+    void *recv = in_place ? MPI_IN_PLACE : out_values;
+
+#if MPI_VERSION >= 4
+    std::vector<MPI_Count> sc(in_count.begin(), in_count.end());
+    std::vector<MPI_Aint> sd(in_disp.begin(), in_disp.end());
+    BOOST_MPI_CHECK_RESULT(MPI_Scatterv_c, (in_values, sc.data(), sd.data(), type, recv,
+                out_count, type, root, comm));
+#else
+    bool large = out_count > large_count_limit || !detail::fits_int(in_count, in_disp);
+
+    if (!detail::any_large(comm, large)) {
+        std::vector<int> sc(in_count.begin(), in_count.end());
+        std::vector<int> sd(in_disp.begin(), in_disp.end());
+        BOOST_MPI_CHECK_RESULT(MPI_Scatterv, (const_cast<void*>(in_values), sc.data(),
+                    sd.data(), type, recv, static_cast<int>(out_count), type, root, comm));
+        return;
+    } // Everything fits in an int
+
+    MPI_Aint lb, extent;
+    BOOST_MPI_CHECK_RESULT(MPI_Type_get_extent, (type, &lb, &extent));
+
+    std::vector<MPI_Request> reqs;
+    if (id == root) {
+        const char *in = static_cast<const char*>(in_values);
+        for (int i = 0; i < comm.size(); i++) {
+            if (i != root && in_count[i]) {
+                reqs.emplace_back();
+                large_isend(in + in_disp[i] * extent, in_count[i], type, i, utility::data_tag,
+                        comm, &reqs.back());
+            }
+        } // Loop over procs
+
+        if (!in_place)
+            std::copy(in + in_disp[root] * extent,
+                    in + (in_disp[root] + in_count[root]) * extent,
+                    static_cast<char*>(out_values));
+    } else if (out_count) {
+        reqs.emplace_back();
+        large_irecv(out_values, out_count, type, root, utility::data_tag, comm, &reqs.back());
+    } // Root sends every block
+
+    BOOST_MPI_CHECK_RESULT(MPI_Waitall, (static_cast<int>(reqs.size()), reqs.data(),
+                MPI_STATUSES_IGNORE));
+#endif
+}
+
+
+}; // namespace mpi
+}; // namespace psrs
+
+
+#endif
@@ -0,0 +1,141 @@
+/* Written by: Eric Tan
+ *
+ * p-way merge used for the final phase of psrs::sort. After the all to all exchange each proc
+ * holds p sorted runs, so merging them is O(n log p) instead of the O(n log n) of a full sort.
+ */
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+#include "parallel.h"
+
+
+namespace psrs {
+namespace detail {
+
+
+/* multiway_merge()
+ * @INPUT: runs = pairs of iterators to sorted runs
+ * @INPUT: out = output iterator
+ * @INPUT: cmp = comparator
+ *
+ * Merges the runs into out using a heap of run heads. Elements are moved out of the runs. Equal
+ * elements keep their run order, so the merge is stable.
+ */
+template <typename RandomIt, typename OutputIt, class Compare>
+OutputIt multiway_merge(std::vector<std::pair<RandomIt, RandomIt> > runs, OutputIt out,
+        Compare cmp)
+{
+    // Heap of run indices ordered by their current head. Ties go to the lower run index.
+    auto heap_cmp = [&runs, &cmp](int a, int b) {
+        if (cmp(*runs[b].first, *runs[a].first))
+            return true;
+        return !cmp(*runs[a].first, *runs[b].first) && a > b;
+    };
+
+    std::vector<int> heap;
+    for (int i = 0; i < static_cast<int>(runs.size()); i++)
+        if (runs[i].first != runs[i].second)
+            heap.push_back(i);
+
+    std::make_heap(heap.begin(), heap.end(), heap_cmp);
+
+    while (heap.size() > 1) {
+        std::pop_heap(heap.begin(), heap.end(), heap_cmp);
+        int r = heap.back();
+
+        *out++ = std::move(*runs[r].first++);
+
+        if (runs[r].first != runs[r].second)
+            std::push_heap(heap.begin(), heap.end(), heap_cmp);
+        else
+            heap.pop_back();
+    } // Merge until one run is left
+
+    if (!heap.empty())
+        out = std::move(runs[heap.front()].first, runs[heap.front()].second, out);
+
+    return out;
+}
+
+
+/* parallel_multiway_merge()
+ * @INPUT: runs = pairs of iterators to sorted runs
+ * @INPUT: out = random access output iterator
+ * @INPUT: cmp = comparator
+ * @INPUT: threads = number of threads to use
+ *
+ * Splits the output into one segment per thread and merges the segments concurrently. Splitters
+ * are picked from regular samples of every run, weighted by run length, and each run is cut at
+ * the lower_bound of every splitter. Every element before a cut is not greater than every element
+ * after it, so the segments can be merged independently.
+ */
+template <typename RandomIt, typename OutputIt, class Compare>
+void parallel_multiway_merge(const std::vector<std::pair<RandomIt, RandomIt> > &runs,
+        OutputIt out, Compare cmp, int threads)
+{
+    typedef typename std::iterator_traits<RandomIt>::difference_type diff_type;
+
+    int k = runs.size();
+    diff_type n = 0;
+    for (auto &r : runs)
+        n += std::distance(r.first, r.second);
+
+    if (threads <= 1 || n < 2 * threads) {
+        multiway_merge(runs, out, cmp);
+        return;
+    } // Not worth splitting
+
+    // Take threads samples from each run. Each sample stands for len / threads elements.
+    std::vector<std::pair<RandomIt, double> > samples;
+    for (auto &r : runs) {
+        diff_type len = std::distance(r.first, r.second);
+        for (int t = 0; t < threads && len > 0; t++)
+            samples.emplace_back(r.first + t * len / threads, static_cast<double>(len) / threads);
+    } // Sample runs
+
+    std::sort(samples.begin(), samples.end(), [&cmp](const auto &a, const auto &b) {
+        return cmp(*a.first, *b.first);
+    });
+
+    // cuts[t][r] is where thread t starts in run r
+    std::vector<std::vector<RandomIt> > cuts(threads + 1, std::vector<RandomIt>(k));
+    for (int r = 0; r < k; r++) {
+        cuts.front()[r] = runs[r].first;
+        cuts.back()[r] = runs[r].second;
+    }
+
+    double weight = 0.0;
+    for (int t = 1, s = 0; t < threads; t++) {
+        while (s < static_cast<int>(samples.size()) - 1 &&
+                weight + samples[s].second < static_cast<double>(t) * n / threads)
+            weight += samples[s++].second;
+
+        for (int r = 0; r < k; r++)
+            cuts[t][r] = std::lower_bound(cuts[t - 1][r], runs[r].second, *samples[s].first, cmp);
+    } // Find cuts for each thread
+
+    std::vector<diff_type> offset(threads + 1, 0);
+    for (int t = 1; t <= threads; t++)
+        for (int r = 0; r < k; r++)
+            offset[t] += std::distance(runs[r].first, cuts[t][r]);
+
+    parallel_for(threads, [&](int t) {
+        std::vector<std::pair<RandomIt, RandomIt> > part(k);
+        for (int r = 0; r < k; r++)
+            part[r] = std::make_pair(cuts[t][r], cuts[t + 1][r]);
+
+        multiway_merge(part, out + offset[t], cmp);
+    });
+}
+
+
+}; // namespace detail
+}; // namespace psrs
+
+
+#endif
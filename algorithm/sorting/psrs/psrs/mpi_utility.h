@@ -1,6 +1,10 @@
 #ifndef MPI_UTILITY_H
 #define MPI_UTILITY_H
 
+#include <vector>
+#include <iterator>
+#include <type_traits>
+
 
 namespace psrs {
 namespace utility {
@@ -9,6 +13,21 @@ namespace utility {
 // message tags
 constexpr int data_tag = 1;
 constexpr int prompt_tag = 2;
+constexpr int stream_tag = 3;
+
+// Traits
+
+/* is_contiguous_iterator
+ *
+ * @Template It = iterator type
+ * True for iterators whose elements are stored contiguously, so the range can be handed to MPI as
+ * a pointer. Only raw pointers and std::vector iterators are recognized.
+ */
+template <typename It, typename T = typename std::iterator_traits<It>::value_type>
+constexpr bool is_contiguous_iterator = std::is_pointer<It>::value ||
+    (!std::is_same<T, bool>::value &&
+     (std::is_same<It, typename std::vector<T>::iterator>::value ||
+      std::is_same<It, typename std::vector<T>::const_iterator>::value));
 
 // Functions
 
@@ -19,7 +38,7 @@ constexpr int prompt_tag = 2;
  *
  * Computes the low index of the block.
  */
-int blk_low(int id, int p, int n) { return id * n / p; }
+long long blk_low(int id, int p, long long n) { return id * n / p; }
 
 
 /* blk_low()
@@ -29,7 +48,7 @@ int blk_low(int id, int p, int n) { return id * n / p; }
  *
  * Computes the high index of the block.
  */
-int blk_high(int id, int p, int n) { return blk_low(id + 1, p, n) - 1; }
+long long blk_high(int id, int p, long long n) { return blk_low(id + 1, p, n) - 1; }
 
 
 /* blk_low()
@@ -39,7 +58,10 @@ int blk_high(int id, int p, int n) { return blk_low(id + 1, p, n) - 1; }
  *
  * Computes the size of the block.
  */
-int blk_size(int id, int p, int n) { return blk_high(id, p, n) - blk_low(id, p, n) + 1; }
+long long blk_size(int id, int p, long long n)
+{
+    return blk_high(id, p, n) - blk_low(id, p, n) + 1;
+}
 
 
 }; // namespace utility
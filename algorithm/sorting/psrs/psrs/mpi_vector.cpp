@@ -1,11 +1,26 @@
 #include <fstream>
+#include <sstream>
 #include <iterator>
+#include <algorithm>
 #include <numeric>
 #include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <boost/mpi/collectives.hpp>
+#include <boost/mpi/datatype.hpp>
+#include <boost/mpi/exception.hpp>
+#include <boost/mpi/nonblocking.hpp>
 
 #include "mpi_vector.h"
 #include "mpi_utility.h"
+#include "all_to_allv.h"
+#include "large_count.h"
 
 
 namespace psrs {
@@ -155,7 +170,9 @@ void mpi_vector<T>::assign(std::initializer_list<T> lst)
  * @INPUT root_process = process containing to pair of iterators
  *
  * Distributes data from [begin, end) into each process's local vector. The data is distributed as
- * evenly as possiable.
+ * evenly as possiable. MPI datatypes go out with a single large_scatterv(), straight from the range
+ * if it is contiguous or through one staging buffer if it is not. Other types are serialized block by
+ * block and sent with nonblocking sends, so the next block is packed while the last is in flight.
  */
 template <typename T>
 template <typename InputIt>
@@ -163,52 +180,91 @@ void mpi_vector<T>::distribute(InputIt begin, InputIt end, int root_process)
 {
     // Special case: 1 proc
     if (comm.size() == 1) {
-        arr.insert(arr.begin(), begin, end);
+        arr.assign(begin, end);
+        is_gathered.reset();
         return;
     }
 
-    int n;
+    int p = comm.size();
+    int id = comm.rank();
+    long long n;
 
     // Compute the number of elements and distribute to all procs
-    if (comm.rank() == root_process)
-        n = static_cast<int>(std::distance(begin, end));
+    if (id == root_process)
+        n = std::distance(begin, end);
 
     boost::mpi::broadcast(comm, n, root_process);
 
-    if (comm.rank() == root_process) {
-        int p = comm.size();
+    long long local_n = utility::blk_size(id, p, n);
 
-        // Create temperory buffer. Largest blk_size occurs on the last processor
-        // so we will use that size to ensure the buffer has enough elements, but won't waste memory
-        std::vector<T> tmp(psrs::utility::blk_size(p - 1, p, n));
+    if constexpr (boost::mpi::is_mpi_datatype<T>::value) {
+        std::vector<long long> send_count, send_disp;
+        std::vector<T> staging;
+        const T *send_buf = nullptr;
 
-        // Track number of elements need to skip because we already processed them
-        int skip = 0;
+        if (id == root_process) {
+            send_count.resize(p);
+            send_disp.resize(p);
+            for (int i = 0; i < p; i++) {
+                send_count[i] = utility::blk_size(i, p, n);
+                send_disp[i] = utility::blk_low(i, p, n);
+            } // Loop over procs
 
-        for (int i = 0; i < comm.size(); ++i) {
-            int send_size = psrs::utility::blk_size(i, p, n);
-
-            if (i == root_process) {
-                if (!arr.empty())
-                    arr.clear();
-                arr.insert(arr.begin(), begin + skip, begin + skip + send_size);
+            if constexpr (utility::is_contiguous_iterator<InputIt>) {
+                send_buf = n ? &*begin : nullptr;
             } else {
-                tmp.clear();
-                tmp.insert(tmp.begin(), begin + skip, begin + skip + send_size);
-                comm.send(i, psrs::utility::data_tag, tmp);
-            } // Copy to arr if i == root_rpocess, else send to proc i
-            skip += send_size;
-        } // Loop over process
+                staging.assign(begin, end);
+                send_buf = staging.data();
+            } // Only copy if MPI can not read the range directly
+        }
+
+        arr.resize(local_n);
+        mpi::large_scatterv(comm, send_buf, send_count, send_disp, arr.data(), local_n,
+                boost::mpi::get_mpi_datatype<T>(), root_process);
     } else {
-        comm.recv(root_process, psrs::utility::data_tag, arr);
-    } // root_process distributes process
+        if (id == root_process) {
+            // At most two blocks are in flight, so the root never holds more than two packed copies
+            std::vector<boost::mpi::request> reqs;
+            std::vector<T> tmp;
+            InputIt it = begin;
+
+            for (int i = 0; i < p; i++) {
+                long long send_size = utility::blk_size(i, p, n);
+
+                if (i == root_process) {
+                    arr.clear();
+                    for (long long j = 0; j < send_size; j++, ++it)
+                        arr.push_back(*it);
+                } else {
+                    tmp.clear();
+                    for (long long j = 0; j < send_size; j++, ++it)
+                        tmp.push_back(*it);
+
+                    if (reqs.size() == 2) {
+                        reqs.front().wait();
+                        reqs.erase(reqs.begin());
+                    } // Wait for the oldest send before packing another block
+
+                    reqs.push_back(comm.isend(i, utility::data_tag, tmp));
+                } // Copy to arr if i == root_process, else send to proc i
+            } // Loop over procs
+
+            boost::mpi::wait_all(reqs.begin(), reqs.end());
+        } else {
+            comm.recv(root_process, utility::data_tag, arr);
+        } // root_process distributes process
+    }
+
+    is_gathered.reset();
 }
 
 
 /* mpi_vector::gather()
  * @INPUT: root_process = process to gather all data to
  *
- * Gathers all vectors spread out amoung procs to root_process.
+ * Gathers all vectors spread out amoung procs to root_process. root_process grows its own vector
+ * once and receives every other block straight into it, non root procs send from their vector and
+ * allocate nothing.
  */
 template <typename T>
 void mpi_vector<T>::gather(int root_process)
@@ -221,30 +277,42 @@ void mpi_vector<T>::gather(int root_process)
     if (is_gathered)
         return;
 
-    std::vector<int> sizes, disp;
-    int local_n = arr.size();
+    int p = comm.size();
+    int id = comm.rank();
+    long long local_n = arr.size();
+    std::vector<long long> sizes, disp;
 
     // Gather each local processor's vector size to root_process
     boost::mpi::gather(comm, local_n, sizes, root_process);
 
-    // Generate displacement and count vectors for mpi::gatherv
-    if (comm.rank() == root_process) {
-        // First displacement is always 0.
-        disp.push_back(0);
-        for (int i = 0; i < sizes.size() - 1; ++i)
-            disp.push_back(disp[i] + sizes[i]);
+    if (id == root_process) {
+        // Generate displacements. First displacement is always 0.
+        disp.assign(p, 0);
+        for (int i = 1; i < p; i++)
+            disp[i] = disp[i - 1] + sizes[i - 1];
+
+        // Grow arr to hold everything and move the local block to where it belongs
+        arr.resize(disp.back() + sizes.back());
+        if (disp[id])
+            std::move_backward(arr.begin(), arr.begin() + local_n,
+                    arr.begin() + disp[id] + local_n);
     }
 
-    // Create temp vector to gather data into
-    int n = std::accumulate(sizes.begin(), sizes.end(), 0);
-    std::vector<T> tmp(n);
-
-    boost::mpi::gatherv(comm, arr, tmp.data(), sizes, disp, root_process);
+    if constexpr (boost::mpi::is_mpi_datatype<T>::value) {
+        // root_process receives in place
+        mpi::large_gatherv(comm, id == root_process ? nullptr : arr.data(), local_n, arr.data(),
+                sizes, disp, boost::mpi::get_mpi_datatype<T>(), root_process);
+    } else {
+        if (id == root_process) {
+            for (int i = 0; i < p; i++)
+                if (i != root_process)
+                    mpi::large_recv(comm, i, utility::data_tag, arr.data() + disp[i], sizes[i]);
+        } else {
+            mpi::large_send(comm, root_process, utility::data_tag, arr.data(), local_n);
+        } // Deserialize every block in place on root_process
+    }
 
-    // Move tmp vector into arr on root_process and delete arr on other procs
-    if (comm.rank() == root_process)
-        arr = std::move(tmp);
-    else
+    if (id != root_process)
         arr.clear();
 
     // Set is_gathered to the proc which all data resides in
@@ -253,43 +321,124 @@ void mpi_vector<T>::gather(int root_process)
 
 
 /* scatter()
- * Gathers all data into proc 0 and scatters evenlly among all processors. Makes no
- * assumption about how the data is distributed, so all data is gathered into one
- * proc and distributed.
+ * Distributes data evenly among all processors. If the data is not gathered on one proc and is
+ * already block distributed nothing is moved. Otherwise all data is gathered into proc 0 first.
+ * Each proc receives its block straight into its own vector and the root keeps its block by
+ * moving it to the front.
  */
 template <typename T>
 void mpi_vector<T>::scatter()
 {
+    int p = comm.size();
+    int id = comm.rank();
     int root_proc;
 
     if (is_gathered) {
         root_proc = is_gathered.value();
     } else {
+        long long n = total_size();
+        bool is_block = static_cast<long long>(arr.size()) == utility::blk_size(id, p, n);
+
+        // Skip everything if every proc already holds its block
+        if (boost::mpi::all_reduce(comm, is_block, std::logical_and<bool>()))
+            return;
+
         root_proc = 0;
         gather(0);
     }
 
+    long long n;
+    if (id == root_proc)
+        n = arr.size();
+    boost::mpi::broadcast(comm, n, root_proc);
+
+    long long local_n = utility::blk_size(id, p, n);
+    std::vector<long long> send_count, send_disp;
+
+    if (id == root_proc) {
+        send_count.resize(p);
+        send_disp.resize(p);
+        for (int i = 0; i < p; i++) {
+            send_count[i] = utility::blk_size(i, p, n);
+            send_disp[i] = utility::blk_low(i, p, n);
+        } // Loop over procs
+    } else {
+        arr.resize(local_n);
+    }
+
+    if constexpr (boost::mpi::is_mpi_datatype<T>::value) {
+        // root_proc keeps its block in place
+        mpi::large_scatterv(comm, arr.data(), send_count, send_disp,
+                id == root_proc ? nullptr : arr.data(), local_n,
+                boost::mpi::get_mpi_datatype<T>(), root_proc);
+    } else {
+        if (id == root_proc) {
+            for (int i = 0; i < p; i++)
+                if (i != root_proc)
+                    mpi::large_send(comm, i, utility::data_tag, arr.data() + send_disp[i],
+                            send_count[i]);
+        } else {
+            mpi::large_recv(comm, root_proc, utility::data_tag, arr.data(), local_n);
+        } // Serialize every block straight out of arr on root_proc
+    }
+
+    // Keep the root's own block
+    if (id == root_proc) {
+        if (send_disp[id])
+            std::move(arr.begin() + send_disp[id], arr.begin() + send_disp[id] + local_n,
+                    arr.begin());
+        arr.resize(local_n);
+    }
+
+    is_gathered.reset();
+}
+
+
+/* rebalance()
+ * Evens out the local sizes without gathering to one proc. Each proc finds its global offset with
+ * MPI_Exscan and sends every element to the proc whose block covers its global index, so global
+ * order is kept and only elements that cross a block boundary leave their proc. Everything moves
+ * with one all_to_allv. Nothing is moved if every proc already holds its block.
+ */
+template <typename T>
+void mpi_vector<T>::rebalance()
+{
+    if (is_gathered) {
+        scatter();
+        return;
+    } // Data on one proc, nothing to gain from the exchange
+
     int p = comm.size();
     int id = comm.rank();
-    int n = total_size();
-    std::vector<int> send_count(p), send_disp(p);
-
-    send_count[0] = utility::blk_size(0, p, n);
-    send_disp[0] = 0;
-    for (int i = 1; i < p; i++) {
-        send_disp[i] = send_disp[i - 1] + send_count[i - 1];
-        send_count[i] = utility::blk_size(i, p, n);
-    }
+    long long local_n = arr.size();
+    long long low = 0, n;
+
+    BOOST_MPI_CHECK_RESULT(MPI_Exscan, (&local_n, &low, 1, MPI_LONG_LONG, MPI_SUM, comm));
+    if (!id)
+        low = 0;
+    boost::mpi::all_reduce(comm, local_n, n, std::plus<long long>());
 
-    int local_n = utility::blk_size(id, p, n);
+    bool is_block = local_n == utility::blk_size(id, p, n);
+    if (boost::mpi::all_reduce(comm, is_block, std::logical_and<bool>()))
+        return;
 
-    T *tmp = new T[local_n];
+    // Overlap of [low, low + local_n) with each proc's block
+    std::vector<long long> send_cnt(p), send_disp(p), recv_cnt(p), recv_disp(p);
+    for (int i = 0; i < p; i++) {
+        long long first = std::max(low, utility::blk_low(i, p, n));
+        long long last = std::min(low + local_n, utility::blk_low(i + 1, p, n));
 
-    boost::mpi::scatterv(comm, arr, send_count, send_disp, tmp, local_n, root_proc);
-    arr.clear();
-    arr.insert(arr.begin(), tmp, tmp + local_n);
+        send_cnt[i] = std::max(0LL, last - first);
+        send_disp[i] = std::min(std::max(0LL, first - low), local_n);
+    } // Loop over procs
+
+    boost::mpi::all_to_all(comm, send_cnt, recv_cnt);
+
+    recv_disp.front() = 0;
+    std::partial_sum(recv_cnt.begin(), recv_cnt.end() - 1, recv_disp.begin() + 1);
 
-    delete[] tmp;
+    mpi::all_to_allv(comm, arr.data(), send_cnt, send_disp, buffer, recv_cnt, recv_disp);
+    swap_buffer();
 }
 
 
@@ -477,6 +626,29 @@ void mpi_vector<T>::move_vector(std::vector<T> &&other)
 }
 
 
+/* get_buffer()
+ * Returns a reference to the proc's receive buffer. The buffer keeps its capacity between
+ * calls so communication routines can receive into it without allocating a new vector.
+ */
+template <typename T>
+std::vector<T>& mpi_vector<T>::get_buffer() noexcept
+{
+    return buffer;
+}
+
+
+/* swap_buffer()
+ * Makes the receive buffer the proc's vector. The old contents are destroyed, but their storage
+ * is kept as the next receive buffer. Call shrink_to_fit() to release it.
+ */
+template <typename T>
+void mpi_vector<T>::swap_buffer() noexcept
+{
+    arr.swap(buffer);
+    buffer.clear();
+}
+
+
 /* at()
  * @INPUT: pos = position
  * Returns a reference to the element at arr[pos];
@@ -583,21 +755,11 @@ const T* mpi_vector<T>::data() const noexcept
 }
 
 
-/* std::vector<T> get_vector()
- * Returns the vector arr
- */
-template <typename T>
-std::vector<T> mpi_vector<T>::get_vector() noexcept
-{
-    return arr;
-}
-
-
-/* std::vector<T> get_vector()
- * Returns const vector
+/* const std::vector<T>& get_vector()
+ * Returns a const reference to the vector arr
  */
 template <typename T>
-const std::vector<T> mpi_vector<T>::get_vector() const noexcept
+const std::vector<T>& mpi_vector<T>::get_vector() const noexcept
 {
     return arr;
 }
@@ -629,9 +791,9 @@ bool mpi_vector<T>::empty() const noexcept
 template <typename T>
 typename mpi_vector<T>::size_type mpi_vector<T>::total_size(int root_proc) const
 {
-    int total_n;
-    int n = arr.size();
-    boost::mpi::reduce(comm, n, total_n, std::plus<int>(), root_proc);
+    long long total_n;
+    long long n = arr.size();
+    boost::mpi::reduce(comm, n, total_n, std::plus<long long>(), root_proc);
 
     return total_n;
 }
@@ -643,9 +805,9 @@ typename mpi_vector<T>::size_type mpi_vector<T>::total_size(int root_proc) const
 template <typename T>
 typename mpi_vector<T>::size_type mpi_vector<T>::total_size() const
 {
-    int total_n;
-    int n = arr.size();
-    boost::mpi::all_reduce(comm, n, total_n, std::plus<int>());
+    long long total_n;
+    long long n = arr.size();
+    boost::mpi::all_reduce(comm, n, total_n, std::plus<long long>());
 
     return total_n;
 }
@@ -692,12 +854,13 @@ typename mpi_vector<T>::size_type mpi_vector<T>::capacity() const noexcept
 
 
 /* shirnk_to_fit()
- * Shrinks vector to match its size
+ * Shrinks vector to match its size and releases the receive buffer
  */
 template <typename T>
 void mpi_vector<T>::shrink_to_fit()
 {
     arr.shrink_to_fit();
+    std::vector<T>().swap(buffer);
 }
 
 
@@ -823,56 +986,244 @@ typename mpi_vector<T>::const_reverse_iterator mpi_vector<T>::crend() const noex
 /* read_file()
  * @INPUT: filepath = path to file
  *
- * Opens a file, Reads its contents, and distributes it amoung each processor.
+ * Reads a file with one element per line in parallel. The file is split into p byte ranges and
+ * every proc reads its range with MPI-IO. A proc owns the lines that start in its range, so it
+ * skips the partial line at the front and reads past the end of its range to finish its last
+ * line. Each proc then parses only its own lines, so procs hold roughly equal numbers of bytes
+ * rather than exactly equal numbers of elements.
  */
 template <typename T>
 void mpi_vector<T>::read_file(const std::string &filepath)
 {
     int p = comm.size();
     int id = comm.rank();
-    int n = 0;
-    std::ifstream in_file;
+    MPI_File fh;
+    MPI_Offset file_size;
+
+    BOOST_MPI_CHECK_RESULT(MPI_File_open, (comm, const_cast<char*>(filepath.c_str()),
+                MPI_MODE_RDONLY, MPI_INFO_NULL, &fh));
+    BOOST_MPI_CHECK_RESULT(MPI_File_get_size, (fh, &file_size));
+
+    // Read one byte before the range to tell if the range starts on a new line
+    MPI_Offset low = id * file_size / p;
+    MPI_Offset high = (id + 1) * file_size / p;
+    MPI_Offset read_low = (low > 0) ? low - 1 : 0;
+    std::vector<char> buffer(high - read_low);
+
+    for (MPI_Offset pos = 0; pos < high - read_low; ) {
+        int cnt = static_cast<int>(std::min<MPI_Offset>(high - read_low - pos, 1 << 30));
+        BOOST_MPI_CHECK_RESULT(MPI_File_read_at, (fh, read_low + pos, buffer.data() + pos, cnt,
+                    MPI_CHAR, MPI_STATUS_IGNORE));
+        pos += cnt;
+    } // Read range in chunks that fit in an int
+
+    // Skip the line started by the previous proc
+    std::size_t start = 0;
+    if (low > 0) {
+        auto it = std::find(buffer.begin(), buffer.end(), '\n');
+        start = (it == buffer.end()) ? buffer.size() : std::distance(buffer.begin(), it) + 1;
+    }
 
-    if (id == (p-1)) {
-        in_file.open(filepath);
+    // Finish the last line if it runs past the range
+    if (start < buffer.size() && buffer.back() != '\n') {
+        std::vector<char> chunk(4096);
+        for (MPI_Offset pos = high; pos < file_size; pos += chunk.size()) {
+            int cnt = static_cast<int>(std::min<MPI_Offset>(chunk.size(), file_size - pos));
+            BOOST_MPI_CHECK_RESULT(MPI_File_read_at, (fh, pos, chunk.data(), cnt, MPI_CHAR,
+                        MPI_STATUS_IGNORE));
+
+            auto it = std::find(chunk.begin(), chunk.begin() + cnt, '\n');
+            buffer.insert(buffer.end(), chunk.begin(), it);
+            if (it != chunk.begin() + cnt)
+                break;
+        } // Read until the next new line or end of file
+    }
 
-        // Compute number of elements by going through the number of lines.
-        std::string dummy_line;
-        while (std::getline(in_file, dummy_line))
-            n++;
+    MPI_File_close(&fh);
 
-        // Reset to beginning of file
-        in_file.clear();
-        in_file.seekg(0, std::ios::beg);
-    } // Proc p-1 opens the file and gets line size
+    // Parse this proc's lines
+    std::istringstream in(std::string(buffer.begin() + start, buffer.end()));
+    T val;
 
-    // Broadcast n to all procs
-    boost::mpi::broadcast(comm, n, p-1);
+    arr.clear();
+    while (in >> val)
+        arr.push_back(val);
 
-    int local_n = utility::blk_size(id, p, n);
+    is_gathered.reset();
+}
 
-    if (id == (p-1)) {
-        // Resize proc p-1 as a buffer since it contains the largest possiable number of elements
-        arr.resize(local_n);
 
-        for (int i = 0; i < p; i++) {
-            for (int j = 0; j < utility::blk_size(i, p, n); j++)
-                in_file >> arr[j];
+/* read_binary()
+ * @INPUT: filepath = path to file
+ *
+ * Reads a file written by write_binary(). The file starts with a header of two uint64_t values,
+ * the element count and sizeof(T), followed by the raw elements. Data is block distributed and
+ * every proc reads only its own block with a collective MPI-IO read. A single proc maps the file
+ * with mmap instead. Throws std::runtime_error if the file's type size does not match T.
+ */
+template <typename T>
+void mpi_vector<T>::read_binary(const std::string &filepath)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "read_binary() needs a trivially copyable T");
 
-            if (i != p-1) {
-                comm.send(i, utility::data_tag, arr);
-            } // Send data if proc is not the last one
-        } //Loop over procs
-    } else {
-        comm.recv(p-1, utility::data_tag, arr);
+    int p = comm.size();
+    int id = comm.rank();
+    std::uint64_t header[2];
 
-        // Resize to local_n to clear any un needed elements since each proc's arr is now the same
-        // as arr on proc p-1
-        arr.resize(local_n);
-    } // Proc p-1 distriubtes data to all other processors
+    if (p == 1) {
+        int fd = open(filepath.c_str(), O_RDONLY);
+        struct stat st;
+
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(header))) {
+            if (fd >= 0)
+                close(fd);
+            throw std::runtime_error("Error: read_binary() could not open " + filepath + '.');
+        } // Check file
+
+        void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            throw std::runtime_error("Error: read_binary() could not map " + filepath + '.');
+
+        std::memcpy(header, map, sizeof(header));
+        if (header[1] != sizeof(T)) {
+            munmap(map, st.st_size);
+            throw std::runtime_error("Error: read_binary() type size in " + filepath +
+                    " does not match.");
+        } // Check type size
+
+        if ((st.st_size - sizeof(header)) / sizeof(T) < header[0]) {
+            munmap(map, st.st_size);
+            throw std::runtime_error("Error: read_binary() size of " + filepath +
+                    " does not match its header.");
+        } // Check file holds every element
+
+        const T *begin = reinterpret_cast<const T*>(static_cast<const char*>(map) + sizeof(header));
+        arr.assign(begin, begin + header[0]);
+        munmap(map, st.st_size);
+
+        is_gathered.reset();
+        return;
+    } // Special case: 1 proc
+
+    MPI_File fh;
+    MPI_Offset file_size;
+    BOOST_MPI_CHECK_RESULT(MPI_File_open, (comm, const_cast<char*>(filepath.c_str()),
+                MPI_MODE_RDONLY, MPI_INFO_NULL, &fh));
+    BOOST_MPI_CHECK_RESULT(MPI_File_get_size, (fh, &file_size));
+
+    if (file_size < static_cast<MPI_Offset>(sizeof(header))) {
+        MPI_File_close(&fh);
+        throw std::runtime_error("Error: read_binary() size of " + filepath +
+                " does not match its header.");
+    } // Check file holds a header
+
+    BOOST_MPI_CHECK_RESULT(MPI_File_read_at_all, (fh, 0, header, sizeof(header), MPI_BYTE,
+                MPI_STATUS_IGNORE));
+
+    if (header[1] != sizeof(T)) {
+        MPI_File_close(&fh);
+        throw std::runtime_error("Error: read_binary() type size in " + filepath +
+                " does not match.");
+    } // Check type size
+
+    if ((file_size - sizeof(header)) / sizeof(T) < header[0]) {
+        MPI_File_close(&fh);
+        throw std::runtime_error("Error: read_binary() size of " + filepath +
+                " does not match its header.");
+    } // Check file holds every element
+
+    long long n = header[0];
+    long long low = id * n / p;
+    long long local_n = (id + 1) * n / p - low;
+
+    // The whole block is one element, so its size is not limited to an int
+    MPI_Datatype block_type = mpi::make_large_type(local_n * sizeof(T), MPI_BYTE);
+
+    arr.resize(local_n);
+    BOOST_MPI_CHECK_RESULT(MPI_File_read_at_all, (fh, sizeof(header) + low * sizeof(T),
+                arr.data(), 1, block_type, MPI_STATUS_IGNORE));
+
+    MPI_Type_free(&block_type);
+    MPI_File_close(&fh);
+
+    is_gathered.reset();
+}
+
+
+/* write_binary()
+ * @INPUT: filepath = path to file
+ *
+ * Writes the distributed vector, in rank order, in the format read by read_binary(). Each proc
+ * finds its offset from an exclusive prefix sum of the local sizes and writes its own elements
+ * with a collective MPI-IO write. Proc 0 writes the header.
+ */
+template <typename T>
+void mpi_vector<T>::write_binary(const std::string &filepath) const
+{
+    static_assert(std::is_trivially_copyable_v<T>, "write_binary() needs a trivially copyable T");
+
+    long long local_n = arr.size();
+    long long low = 0, n = 0;
+
+    BOOST_MPI_CHECK_RESULT(MPI_Exscan, (&local_n, &low, 1, MPI_LONG_LONG, MPI_SUM, comm));
+    if (!comm.rank())
+        low = 0;
+    boost::mpi::all_reduce(comm, local_n, n, std::plus<long long>());
+
+    MPI_File fh;
+    BOOST_MPI_CHECK_RESULT(MPI_File_open, (comm, const_cast<char*>(filepath.c_str()),
+                MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh));
+    BOOST_MPI_CHECK_RESULT(MPI_File_set_size, (fh, 0));
+
+    std::uint64_t header[2] = {static_cast<std::uint64_t>(n), sizeof(T)};
+    int header_cnt = comm.rank() ? 0 : sizeof(header);
+
+    MPI_Datatype block_type = mpi::make_large_type(local_n * sizeof(T), MPI_BYTE);
+
+    BOOST_MPI_CHECK_RESULT(MPI_File_write_at_all, (fh, 0, header, header_cnt, MPI_BYTE,
+                MPI_STATUS_IGNORE));
+    BOOST_MPI_CHECK_RESULT(MPI_File_write_at_all, (fh, sizeof(header) + low * sizeof(T),
+                const_cast<T*>(arr.data()), 1, block_type, MPI_STATUS_IGNORE));
+
+    MPI_Type_free(&block_type);
+    MPI_File_close(&fh);
+}
+
+
+/* write_file()
+ * @INPUT: filepath = path to file
+ * @INPUT: delim = delimiter written after every element. Defaults to space
+ *
+ * Writes the distributed vector to a text file in rank order, with the same formatting as
+ * output(). Every proc formats its own elements, finds its byte offset from an exclusive prefix
+ * sum of the formatted sizes and writes its slice with a collective MPI-IO write, so no proc has
+ * to hold more than its own data.
+ */
+template <typename T>
+void mpi_vector<T>::write_file(const std::string &filepath, const std::string &delim) const
+{
+    std::ostringstream ss;
+    std::copy(arr.begin(), arr.end(), std::ostream_iterator<T>(ss, delim.c_str()));
+    const std::string text = ss.str();
+
+    long long bytes = text.size();
+    long long offset = 0;
+
+    BOOST_MPI_CHECK_RESULT(MPI_Exscan, (&bytes, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm));
+    if (!comm.rank())
+        offset = 0;
+
+    MPI_File fh;
+    BOOST_MPI_CHECK_RESULT(MPI_File_open, (comm, const_cast<char*>(filepath.c_str()),
+                MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh));
+    BOOST_MPI_CHECK_RESULT(MPI_File_set_size, (fh, 0));
+    MPI_Datatype text_type = mpi::make_large_type(bytes, MPI_CHAR);
+    BOOST_MPI_CHECK_RESULT(MPI_File_write_at_all, (fh, offset, const_cast<char*>(text.data()),
+                1, text_type, MPI_STATUS_IGNORE));
+    MPI_Type_free(&text_type);
 
-    if (in_file.is_open())
-        in_file.close();
+    MPI_File_close(&fh);
 }
 
 
@@ -888,7 +1239,7 @@ void mpi_vector<T>::output(std::ostream &os, int root_process, const std::string
 {
     int p = comm.size();
     int id = comm.rank();
-    int n = total_size();
+    long long n = total_size();
     std::ostream_iterator<T> out_it(os, delim.c_str());
 
     if (p == 1) {
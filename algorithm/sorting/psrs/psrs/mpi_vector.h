@@ -6,6 +6,8 @@
 
 #include <boost/mpi/communicator.hpp>
 #include <boost/mpi/collectives.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
 
 
 namespace psrs {
@@ -54,6 +56,7 @@ class mpi_vector
             void distribute(InputIt begin, InputIt end, int root_process);
         void gather(int root_process);
         void scatter();
+        void rebalance();
 
         // Modify
         void clear() noexcept;
@@ -76,6 +79,8 @@ class mpi_vector
         void resize(size_type count, const T &val);
         void swap_vector(std::vector<T> &other);
         void move_vector(std::vector<T> &&other);
+        std::vector<T>& get_buffer() noexcept;
+        void swap_buffer() noexcept;
 
         // Element / data access / communicator access
         reference at(size_type pos);
@@ -88,8 +93,7 @@ class mpi_vector
         const_reference back() const;
         T* data() noexcept;
         const T* data() const noexcept;
-        std::vector<T> get_vector() noexcept;
-        const std::vector<T> get_vector() const noexcept;
+        const std::vector<T>& get_vector() const noexcept;
         const boost::mpi::communicator get_comm() const noexcept;
 
         // Capacity
@@ -118,11 +122,15 @@ class mpi_vector
 
         // Other
         void read_file(const std::string &filepath);
+        void read_binary(const std::string &filepath);
+        void write_binary(const std::string &filepath) const;
+        void write_file(const std::string &filepath, const std::string &delim=" ") const;
         void output(std::ostream &os, int root_process, const std::string &delim=" ") const;
 
     private:
         boost::mpi::communicator comm;
         std::vector<T> arr;
+        std::vector<T> buffer;
         std::optional<int> is_gathered;
 };
 
@@ -0,0 +1,214 @@
+/* Written by: Eric Tan
+ *
+ * Overlapped exchange and merge for psrs::sort. The bucket sizes are swapped with MPI_Ialltoall
+ * while the outgoing buckets are already being sent, and the incoming runs are merged as soon as
+ * they arrive instead of after the whole exchange.
+ */
+#ifndef OVERLAP_H
+#define OVERLAP_H
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <mpi.h>
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/datatype.hpp>
+#include <boost/mpi/exception.hpp>
+#include <boost/mpi/timer.hpp>
+
+#include "mpi_vector.h"
+#include "mpi_utility.h"
+#include "all_to_allv.h"
+#include "large_count.h"
+#include "sort_stats.h"
+
+
+namespace psrs {
+namespace detail {
+
+
+/* class: merge_tree
+ *
+ * @Template RandomIt = iterator into the receive buffer
+ * @Template Compare = comparator
+ * Binary tree over p adjacent sorted runs. When both children of a node have arrived, their
+ * ranges are merged in place and the node counts as arrived. Every level merges each element
+ * once, so the total work is O(n log p) no matter what order the runs arrive in. Left children
+ * hold lower ranks and the merge is stable, so equal elements stay in rank order.
+ */
+template <typename RandomIt, class Compare>
+class merge_tree
+{
+    public:
+        merge_tree(RandomIt first, const std::vector<long long> &disp,
+                const std::vector<long long> &cnt,
+                Compare c) : base(first), cmp(c)
+        {
+            int p = disp.size();
+            for (leaves = 1; leaves < p; leaves *= 2)
+                ;
+
+            long long end = p ? disp.back() + cnt.back() : 0;
+            lo.assign(2 * leaves, end);
+            hi.assign(2 * leaves, end);
+            arrived.assign(2 * leaves, 0);
+
+            for (int i = 0; i < leaves; i++) {
+                if (i < p) {
+                    lo[leaves + i] = disp[i];
+                    hi[leaves + i] = disp[i] + cnt[i];
+                }
+                arrived[leaves + i] = i >= p;
+            } // Padding leaves are empty and already there
+
+            for (int node = leaves - 1; node > 0; node--) {
+                lo[node] = lo[2 * node];
+                hi[node] = hi[2 * node + 1];
+                arrived[node] = arrived[2 * node] && arrived[2 * node + 1];
+            } // Build inner nodes
+        }
+
+        /* arrive()
+         * @INPUT: run = index of the run that arrived
+         *
+         * Marks a run as arrived and merges every node that became complete.
+         */
+        void arrive(int run)
+        {
+            int node = leaves + run;
+            arrived[node] = 1;
+
+            for (node /= 2; node > 0; node /= 2) {
+                if (!arrived[2 * node] || !arrived[2 * node + 1])
+                    break;
+
+                std::inplace_merge(base + lo[node], base + lo[2 * node + 1], base + hi[node], cmp);
+                arrived[node] = 1;
+            } // Walk up the tree
+        }
+
+    private:
+        RandomIt base;
+        Compare cmp;
+        int leaves;
+        std::vector<long long> lo, hi;
+        std::vector<char> arrived;
+};
+
+
+/* overlapped_exchange_merge()
+ * @INPUT: comm = communicator
+ * @INPUT: data = locally sorted data, replaced by this proc's sorted bucket
+ * @INPUT: cmp = comparator
+ * @INPUT: send_cnt, send_disp = count and displacement of every outgoing bucket
+ * @INPUT: timings = records count exchange, data exchange and merge times
+ *
+ * Only for types with an MPI_Datatype. The bucket sizes go out with MPI_Ialltoall, and every
+ * outgoing bucket is posted with MPI_Isend before the sizes come back. Once they do, one
+ * MPI_Irecv is posted per source straight into data's buffer, and every run is handed to a
+ * merge_tree as soon as MPI_Waitany reports it, so merging overlaps with the rest of the exchange.
+ * Buckets past the int limit are sent as one large datatype. data_exchange covers the whole
+ * exchange, merge is the part of it spent merging.
+ */
+template <typename T, class Compare>
+psrs::mpi::xfer_size overlapped_exchange_merge(const boost::mpi::communicator &comm,
+        psrs::mpi_vector<T> &data, Compare cmp, const std::vector<long long> &send_cnt,
+        const std::vector<long long> &send_disp, sort_timings &timings)
+{
+    boost::mpi::timer phase_timer;
+    MPI_Datatype dtype = boost::mpi::get_mpi_datatype<T>();
+    int p = comm.size();
+    int id = comm.rank();
+    std::vector<long long> recv_cnt(p), recv_disp(p, 0);
+    MPI_Request count_req;
+
+    BOOST_MPI_CHECK_RESULT(MPI_Ialltoall, (const_cast<long long*>(send_cnt.data()), 1,
+                MPI_LONG_LONG, recv_cnt.data(), 1, MPI_LONG_LONG, comm, &count_req));
+
+    // Sends only need this proc's counts, so they start while the counts are in flight
+    std::vector<MPI_Request> send_req;
+    for (int i = 1; i < p; i++) {
+        int dest = (id + i) % p;
+
+        if (!send_cnt[dest])
+            continue;
+
+        send_req.emplace_back();
+        psrs::mpi::large_isend(data.data() + send_disp[dest], send_cnt[dest], dtype, dest,
+                utility::data_tag, comm, &send_req.back());
+    } // Loop over procs, starting after this one
+
+    BOOST_MPI_CHECK_RESULT(MPI_Wait, (&count_req, MPI_STATUS_IGNORE));
+    std::partial_sum(recv_cnt.begin(), recv_cnt.end() - 1, recv_disp.begin() + 1);
+
+    timings.count_exchange = phase_timer.elapsed();
+    phase_timer.restart();
+
+    std::vector<T> &buffer = data.get_buffer();
+    buffer.resize(recv_disp.back() + recv_cnt.back());
+
+    std::vector<MPI_Request> recv_req;
+    std::vector<int> recv_src;
+    for (int i = 1; i < p; i++) {
+        int src = (id - i + p) % p;
+
+        if (!recv_cnt[src])
+            continue;
+
+        recv_req.emplace_back();
+        recv_src.push_back(src);
+        psrs::mpi::large_irecv(buffer.data() + recv_disp[src], recv_cnt[src], dtype, src,
+                utility::data_tag, comm, &recv_req.back());
+    } // Loop over procs, starting before this one
+
+    merge_tree<typename std::vector<T>::iterator, Compare> tree(buffer.begin(), recv_disp,
+            recv_cnt, cmp);
+    boost::mpi::timer merge_timer;
+    double merge_time = 0.0;
+
+    // The local bucket and empty runs are there already
+    std::copy(data.begin() + send_disp[id], data.begin() + send_disp[id] + send_cnt[id],
+            buffer.begin() + recv_disp[id]);
+    for (int i = 0; i < p; i++) {
+        if (i == id || !recv_cnt[i]) {
+            merge_timer.restart();
+            tree.arrive(i);
+            merge_time += merge_timer.elapsed();
+        }
+    } // Loop over procs
+
+    for (std::size_t done = 0; done < recv_req.size(); done++) {
+        int idx;
+        BOOST_MPI_CHECK_RESULT(MPI_Waitany, (static_cast<int>(recv_req.size()), recv_req.data(),
+                    &idx, MPI_STATUS_IGNORE));
+
+        merge_timer.restart();
+        tree.arrive(recv_src[idx]);
+        merge_time += merge_timer.elapsed();
+    } // Merge every run as it arrives
+
+    BOOST_MPI_CHECK_RESULT(MPI_Waitall, (static_cast<int>(send_req.size()), send_req.data(),
+                MPI_STATUSES_IGNORE));
+    data.swap_buffer();
+
+    timings.data_exchange = phase_timer.elapsed();
+    timings.merge = merge_time;
+
+    psrs::mpi::xfer_size xfer;
+    for (int i = 0; i < p; i++) {
+        if (i != id) {
+            xfer.sent += send_cnt[i] * static_cast<long long>(sizeof(T));
+            xfer.received += recv_cnt[i] * static_cast<long long>(sizeof(T));
+        }
+    } // Count bytes
+
+    return xfer;
+}
+
+
+}; // namespace detail
+}; // namespace psrs
+
+
+#endif
@@ -0,0 +1,149 @@
+/* Written by: Eric Tan
+ *
+ * Thread helpers for the local phases of psrs::sort. Each rank can use several threads to sort
+ * and partition its own data.
+ */
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <iterator>
+#include <algorithm>
+
+#include "radix.h"
+
+
+namespace psrs {
+namespace detail {
+
+
+/* parallel_for()
+ * @INPUT: count = number of tasks
+ * @INPUT: f = callable taking the task index
+ *
+ * Runs f(0), ..., f(count - 1), each on its own thread. Task 0 runs on the calling thread.
+ */
+template <class Function>
+void parallel_for(int count, Function f)
+{
+    std::vector<std::thread> workers;
+
+    for (int i = 1; i < count; i++)
+        workers.emplace_back(f, i);
+
+    if (count > 0)
+        f(0);
+
+    for (auto &w : workers)
+        w.join();
+}
+
+
+/* parallel_sort()
+ * @INPUT: first, last = range to sort
+ * @INPUT: cmp = comparator
+ * @INPUT: threads = number of threads to use
+ * @INPUT: stable = keep equal elements in their original order
+ *
+ * Splits the range into one run per thread and sorts the runs concurrently. Neighbouring runs
+ * are then merged pairwise, doubling the run length each round, until one sorted run is left.
+ * The merges are stable, so the result is stable whenever the runs are sorted stably. Runs of
+ * integers or floating point values compared with std::less or std::greater are radix sorted.
+ * Returns true if every run was radix sorted.
+ */
+template <typename RandomIt, class Compare>
+bool parallel_sort(RandomIt first, RandomIt last, Compare cmp, int threads, bool stable = false)
+{
+    typedef radix_traits<typename std::iterator_traits<RandomIt>::value_type, Compare> radix;
+
+    auto n = std::distance(first, last);
+    auto sort_run = [&cmp, stable](RandomIt lo, RandomIt hi) {
+        if constexpr (radix::sortable) {
+            if (radix::use(stable) && std::distance(lo, hi) >= radix_min_size) {
+                radix_sort(lo, hi, radix::descending);
+                return true;
+            }
+        } // Radix sort when the comparator is a plain value order
+
+        if (stable)
+            std::stable_sort(lo, hi, cmp);
+        else
+            std::sort(lo, hi, cmp);
+
+        return false;
+    };
+
+    if (threads <= 1 || n < 2 * threads)
+        return sort_run(first, last); // Not worth splitting
+
+    std::vector<RandomIt> bounds(threads + 1);
+    for (int t = 0; t <= threads; t++)
+        bounds[t] = first + t * n / threads;
+
+    std::vector<char> radix_sorted(threads);
+    parallel_for(threads, [&bounds, &sort_run, &radix_sorted](int t) {
+        radix_sorted[t] = sort_run(bounds[t], bounds[t + 1]);
+    });
+
+    for (int width = 1; width < threads; width *= 2) {
+        int merges = (threads + 2 * width - 1) / (2 * width);
+
+        parallel_for(merges, [&bounds, &cmp, width, threads](int m) {
+            int lo = 2 * m * width;
+            int mid = std::min(lo + width, threads);
+            int hi = std::min(lo + 2 * width, threads);
+
+            if (mid < hi)
+                std::inplace_merge(bounds[lo], bounds[mid], bounds[hi], cmp);
+        });
+    } // Merge runs
+
+    return std::all_of(radix_sorted.begin(), radix_sorted.end(), [](char r) { return r; });
+}
+
+
+/* parallel_partition()
+ * @INPUT: first, last = sorted range to partition
+ * @INPUT: pivots = sorted pivots
+ * @INPUT: cmp = comparator
+ * @INPUT: disp = output displacements, must hold pivots.size() + 1 elements
+ * @INPUT: threads = number of threads to use
+ * @INPUT: radix_sorted = parallel_sort() radix sorted every run of the range
+ *
+ * Computes the start of each bucket in [first, last). Bucket i holds the elements before
+ * pivots[i], so disp[0] = 0 and disp[i + 1] = lower_bound(pivots[i]). The pivots are split
+ * evenly among the threads. Ranges that parallel_sort() radix sorted are searched on radix keys.
+ */
+template <typename RandomIt, typename T, class Compare>
+void parallel_partition(RandomIt first, RandomIt last, const std::vector<T> &pivots,
+        Compare cmp, std::vector<long long> &disp, int threads, bool radix_sorted = false)
+{
+    typedef radix_traits<T, Compare> radix;
+
+    int np = pivots.size();
+    threads = std::max(1, std::min(threads, np));
+
+    disp.front() = 0;
+    parallel_for(threads, [&](int t) {
+        int lo = t * np / threads;
+        int hi = (t + 1) * np / threads;
+
+        if constexpr (radix::sortable) {
+            if (radix_sorted) {
+                radix_partition(first, last, pivots, radix::descending, disp, lo, hi);
+                return;
+            }
+        } // Search on radix keys
+
+        for (int i = lo; i < hi; i++)
+            disp[i + 1] = std::distance(first, std::lower_bound(first, last, pivots[i], cmp));
+    });
+}
+
+
+}; // namespace detail
+}; // namespace psrs
+
+
+#endif
@@ -0,0 +1,223 @@
+/* Written by: Eric Tan
+ *
+ * LSD radix sort for the local phases of psrs::sort. Integers and floating point values are mapped
+ * to unsigned keys whose unsigned order matches the value order, so a byte at a time counting sort
+ * can replace comparison sorting when the comparator is std::less or std::greater.
+ */
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+
+namespace psrs {
+namespace detail {
+
+
+// Ranges shorter than this are comparison sorted, the histograms cost more than they save
+constexpr std::ptrdiff_t radix_min_size = 256;
+
+
+/* struct: radix_traits
+ *
+ * @Template T = value type
+ * @Template Compare = comparator
+ * sortable is true when T is an integer or a 32/64 bit floating point type and Compare is
+ * std::less or std::greater. descending is true for std::greater.
+ */
+template <typename T, class Compare>
+struct radix_traits
+{
+    static constexpr bool arithmetic = (std::is_integral_v<T> && !std::is_same_v<T, bool>) ||
+        (std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+    static constexpr bool ascending = std::is_same_v<Compare, std::less<T> > ||
+        std::is_same_v<Compare, std::less<> >;
+    static constexpr bool descending = std::is_same_v<Compare, std::greater<T> > ||
+        std::is_same_v<Compare, std::greater<> >;
+    static constexpr bool sortable = arithmetic && (ascending || descending);
+
+    // -0.0 and 0.0 compare equal but get different keys, so stable sorts of floating point values
+    // keep using std::stable_sort
+    static constexpr bool use(bool stable) { return !stable || std::is_integral_v<T>; }
+};
+
+
+/* struct: radix_key_type
+ *
+ * @Template T = arithmetic type
+ * Unsigned integer with the same size as T.
+ */
+template <typename T, std::size_t Size = sizeof(T)>
+struct radix_key_type;
+
+template <typename T> struct radix_key_type<T, 1> { typedef std::uint8_t type; };
+template <typename T> struct radix_key_type<T, 2> { typedef std::uint16_t type; };
+template <typename T> struct radix_key_type<T, 4> { typedef std::uint32_t type; };
+template <typename T> struct radix_key_type<T, 8> { typedef std::uint64_t type; };
+
+
+/* to_radix_key()
+ * @INPUT: val = value to map
+ * @INPUT: descending = reverse the order
+ *
+ * Order preserving map to an unsigned key. Signed integers flip the sign bit. Floating point
+ * values flip every bit when negative and only the sign bit otherwise.
+ */
+template <typename T>
+inline typename radix_key_type<T>::type to_radix_key(T val, bool descending)
+{
+    typedef typename radix_key_type<T>::type key_type;
+    constexpr key_type sign = key_type(1) << (8 * sizeof(T) - 1);
+    key_type key;
+
+    std::memcpy(&key, &val, sizeof(T));
+
+    if constexpr (std::is_floating_point_v<T>)
+        key = (key & sign) ? key_type(~key) : key_type(key | sign);
+    else if constexpr (std::is_signed_v<T>)
+        key ^= sign;
+
+    return descending ? key_type(~key) : key;
+}
+
+
+/* from_radix_key()
+ * @INPUT: key = key made by to_radix_key()
+ * @INPUT: descending = key was made in descending order
+ *
+ * Inverse of to_radix_key().
+ */
+template <typename T>
+inline T from_radix_key(typename radix_key_type<T>::type key, bool descending)
+{
+    typedef typename radix_key_type<T>::type key_type;
+    constexpr key_type sign = key_type(1) << (8 * sizeof(T) - 1);
+    T val;
+
+    if (descending)
+        key = ~key;
+
+    if constexpr (std::is_floating_point_v<T>)
+        key = (key & sign) ? key_type(key & ~sign) : key_type(~key);
+    else if constexpr (std::is_signed_v<T>)
+        key ^= sign;
+
+    std::memcpy(&val, &key, sizeof(T));
+    return val;
+}
+
+
+/* to_partition_key()
+ * @INPUT: val = value to map
+ * @INPUT: descending = reverse the order
+ *
+ * Same as to_radix_key(), but -0.0 gets the key of 0.0. The two compare equal, so a sorted range
+ * can hold them in either order, and only keys that ignore the sign of zero stay in order.
+ */
+template <typename T>
+inline typename radix_key_type<T>::type to_partition_key(T val, bool descending)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        if (val == T(0))
+            val = T(0);
+
+    return to_radix_key<T>(val, descending);
+}
+
+
+/* radix_sort()
+ * @INPUT: first, last = range of arithmetic values to sort
+ * @INPUT: descending = sort largest first
+ *
+ * LSD radix sort. Values are mapped to keys, the keys are counting sorted one digit at a time and
+ * mapped back. 64 bit keys use 11 bit digits (6 passes), smaller keys use 8 bit digits. The
+ * histograms for every digit are built in a single pass, and a digit where every key falls in the
+ * same bucket is skipped. Stable on keys, so equal values keep their order, except that -0.0 and
+ * 0.0 are distinct keys.
+ */
+template <typename RandomIt>
+void radix_sort(RandomIt first, RandomIt last, bool descending)
+{
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    typedef typename radix_key_type<T>::type key_type;
+    constexpr int bits = sizeof(T) == 8 ? 11 : 8;
+    constexpr int passes = (8 * sizeof(T) + bits - 1) / bits;
+    constexpr key_type mask = (key_type(1) << bits) - 1;
+
+    std::size_t n = std::distance(first, last);
+    if (n < 2)
+        return;
+
+    std::vector<key_type> keys(n), tmp(n);
+    std::vector<std::size_t> count(passes << bits, 0);
+
+    for (std::size_t i = 0; i < n; i++) {
+        keys[i] = to_radix_key<T>(first[i], descending);
+        for (int d = 0; d < passes; d++)
+            count[(d << bits) + ((keys[i] >> (bits * d)) & mask)]++;
+    } // Build keys and every histogram
+
+    for (int d = 0; d < passes; d++) {
+        auto c = count.begin() + (d << bits);
+
+        if (*std::max_element(c, c + (1 << bits)) == n)
+            continue;
+
+        std::size_t sum = 0;
+        for (int b = 0; b < (1 << bits); b++) {
+            std::size_t cnt = c[b];
+            c[b] = sum;
+            sum += cnt;
+        } // Counts to offsets
+
+        for (std::size_t i = 0; i < n; i++)
+            tmp[c[(keys[i] >> (bits * d)) & mask]++] = keys[i];
+
+        keys.swap(tmp);
+    } // Loop over digits
+
+    for (std::size_t i = 0; i < n; i++)
+        first[i] = from_radix_key<T>(keys[i], descending);
+}
+
+
+/* radix_partition()
+ * @INPUT: first, last = range whose runs were all sorted by radix_sort()
+ * @INPUT: pivots = sorted pivots
+ * @INPUT: descending = range is sorted largest first
+ * @INPUT: disp = output displacements
+ * @INPUT: lo, hi = range of pivots to place
+ *
+ * Sets disp[i + 1] to the start of the elements not before pivots[i], for lo <= i < hi. The search
+ * runs on keys from to_partition_key() with plain integer compares. Pivots are sorted, so every
+ * search starts at the previous cut.
+ */
+template <typename RandomIt, typename T>
+void radix_partition(RandomIt first, RandomIt last, const std::vector<T> &pivots,
+        bool descending, std::vector<long long> &disp, int lo, int hi)
+{
+    typedef typename radix_key_type<T>::type key_type;
+    auto key_less = [descending](const T &val, key_type key) {
+        return to_partition_key<T>(val, descending) < key;
+    };
+
+    RandomIt cut = first;
+    for (int i = lo; i < hi; i++) {
+        cut = std::lower_bound(cut, last, to_partition_key<T>(pivots[i], descending),
+                key_less);
+        disp[i + 1] = std::distance(first, cut);
+    } // Loop over pivots
+}
+
+
+}; // namespace detail
+}; // namespace psrs
+
+
+#endif
@@ -0,0 +1,245 @@
+/* Written by: Eric Tan
+ *
+ * Distributed selection for psrs. Finds the k-th smallest element, the k smallest elements or a
+ * set of quantiles without sorting. Every round picks a pivot from a small sample, splits each
+ * proc's candidates around it with a local partition and only exchanges counts. Once few enough
+ * candidates are left they are gathered and finished with std::nth_element.
+ */
+#ifndef SELECT_H
+#define SELECT_H
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <mpi.h>
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/exception.hpp>
+
+#include "mpi_vector.h"
+
+
+namespace psrs {
+namespace detail {
+
+
+// Number of sample elements each proc offers per selection round
+constexpr int select_samples = 16;
+
+// Candidates are gathered and solved locally once this few are left
+constexpr long long select_gather_size = 4096;
+
+
+/* gather_all()
+ * @INPUT: comm = communicator
+ * @INPUT: first, last = local range
+ *
+ * Returns every proc's range, concatenated in rank order, on all procs.
+ */
+template <typename T, typename RandomIt>
+std::vector<T> gather_all(const boost::mpi::communicator &comm, RandomIt first, RandomIt last)
+{
+    std::vector<T> local(first, last), all;
+    std::vector<std::vector<T> > parts;
+
+    boost::mpi::all_gather(comm, local, parts);
+    for (auto &part : parts)
+        all.insert(all.end(), part.begin(), part.end());
+
+    return all;
+}
+
+
+/* select_impl()
+ * @INPUT: comm = communicator
+ * @INPUT: data = local data, reordered in place
+ * @INPUT: k = global rank to find, 0 <= k < total size
+ * @INPUT: cmp = comparator
+ *
+ * Narrows every proc's candidates [lo, hi) until the k-th element is found. Each round the
+ * pivot is the sample element at the target's relative position among all samples. Candidates
+ * are partitioned into less than, equal to and greater than the pivot, and one all_reduce of the
+ * three counts tells every proc which part holds the target.
+ */
+template <typename T, class Compare>
+T select_impl(const boost::mpi::communicator &comm, psrs::mpi_vector<T> &data, long long k,
+        Compare cmp)
+{
+    auto lo = data.begin();
+    auto hi = data.end();
+
+    while (true) {
+        long long local_n = std::distance(lo, hi);
+        long long n;
+        boost::mpi::all_reduce(comm, local_n, n, std::plus<long long>());
+
+        if (n <= select_gather_size) {
+            std::vector<T> all = detail::gather_all<T>(comm, lo, hi);
+            std::nth_element(all.begin(), all.begin() + k, all.end(), cmp);
+            return all[k];
+        } // Few candidates left, finish locally
+
+        // Evenly spaced samples from every proc's candidates
+        std::vector<T> samples;
+        for (int s = 0; s < select_samples && s < local_n; s++)
+            samples.push_back(lo[(2 * s + 1) * local_n / (2 * select_samples)]);
+
+        samples = detail::gather_all<T>(comm, samples.begin(), samples.end());
+        auto target = samples.begin() + static_cast<long long>(
+                static_cast<double>(k) / n * (samples.size() - 1));
+        std::nth_element(samples.begin(), target, samples.end(), cmp);
+        T pivot = *target;
+
+        // Three way split of the candidates around the pivot
+        auto mid = std::partition(lo, hi, [&](const T &x) { return cmp(x, pivot); });
+        auto top = std::partition(mid, hi, [&](const T &x) { return !cmp(pivot, x); });
+
+        long long local_cnt[2] = {std::distance(lo, mid), std::distance(mid, top)};
+        long long cnt[2];
+        BOOST_MPI_CHECK_RESULT(MPI_Allreduce, (local_cnt, cnt, 2, MPI_LONG_LONG, MPI_SUM, comm));
+
+        if (k < cnt[0]) {
+            hi = mid;
+        } else if (k < cnt[0] + cnt[1]) {
+            return pivot;
+        } else {
+            k -= cnt[0] + cnt[1];
+            lo = top;
+        } // Keep the part holding the target
+    } // Selection rounds
+}
+
+
+}; // namespace detail
+
+
+/* nth_element()
+ * @INPUT: data = distributed data, local elements are reordered
+ * @INPUT: k = global rank, 0 <= k < data.total_size()
+ * @INPUT: cmp = comparator. Default to std::less<T>
+ *
+ * Returns, on every proc, the element that would be at global position k if data were sorted.
+ * Only counts and small samples are exchanged. Throws std::runtime_error if k is out of range.
+ */
+template <typename T, class Compare>
+T nth_element(psrs::mpi_vector<T> &data, long long k, Compare cmp)
+{
+    const boost::mpi::communicator comm = data.get_comm();
+    long long local_n = data.size();
+    long long n;
+
+    boost::mpi::all_reduce(comm, local_n, n, std::plus<long long>());
+
+    if (k < 0 || k >= n)
+        throw std::runtime_error("Error: nth_element() k = " + std::to_string(k) +
+                " is out of range.");
+
+    return detail::select_impl(comm, data, k, cmp);
+}
+
+
+template <typename T>
+T nth_element(psrs::mpi_vector<T> &data, long long k)
+{
+    return psrs::nth_element(data, k, std::less<T>());
+}
+
+
+/* partial_sort()
+ * @INPUT: data = distributed data, local elements are reordered
+ * @INPUT: k = number of elements
+ * @INPUT: cmp = comparator. Default to std::less<T>
+ *
+ * Returns the k smallest elements in sorted order on every proc. The k-th element is found with
+ * nth_element(), then every proc contributes its elements before it plus its share of the ties,
+ * so only k elements are gathered. k larger than the total size returns everything.
+ */
+template <typename T, class Compare>
+std::vector<T> partial_sort(psrs::mpi_vector<T> &data, long long k, Compare cmp)
+{
+    const boost::mpi::communicator comm = data.get_comm();
+    long long n = data.total_size();
+
+    k = std::min(k, n);
+    if (k <= 0)
+        return std::vector<T>();
+
+    T kth = detail::select_impl(comm, data, k - 1, cmp);
+
+    // Elements before kth first, then the ties
+    auto mid = std::partition(data.begin(), data.end(), [&](const T &x) { return cmp(x, kth); });
+    auto top = std::partition(mid, data.end(), [&](const T &x) { return !cmp(kth, x); });
+
+    long long less = std::distance(data.begin(), mid);
+    long long ties = std::distance(mid, top);
+    long long total_less, ties_before = 0;
+
+    boost::mpi::all_reduce(comm, less, total_less, std::plus<long long>());
+    BOOST_MPI_CHECK_RESULT(MPI_Exscan, (&ties, &ties_before, 1, MPI_LONG_LONG, MPI_SUM, comm));
+    if (!comm.rank())
+        ties_before = 0;
+
+    // Lower ranks fill the ties first
+    long long need = k - total_less;
+    long long take = std::max(0LL, std::min(ties, need - ties_before));
+
+    std::vector<T> result = detail::gather_all<T>(comm, data.begin(), mid + take);
+    std::sort(result.begin(), result.end(), cmp);
+
+    return result;
+}
+
+
+template <typename T>
+std::vector<T> partial_sort(psrs::mpi_vector<T> &data, long long k)
+{
+    return psrs::partial_sort(data, k, std::less<T>());
+}
+
+
+/* quantiles()
+ * @INPUT: data = distributed data, local elements are reordered
+ * @INPUT: q = quantiles in [0, 1]
+ * @INPUT: cmp = comparator. Default to std::less<T>
+ *
+ * Returns, on every proc, the element at global position floor(q * (n - 1)) for each quantile,
+ * in the order given. Each quantile is one distributed selection. Throws std::runtime_error if
+ * data is empty or a quantile is outside [0, 1].
+ */
+template <typename T, class Compare>
+std::vector<T> quantiles(psrs::mpi_vector<T> &data, const std::vector<double> &q, Compare cmp)
+{
+    const boost::mpi::communicator comm = data.get_comm();
+    long long n = data.total_size();
+    std::vector<T> result;
+
+    if (!n)
+        throw std::runtime_error("Error: quantiles() of an empty mpi_vector.");
+
+    for (double x : q) {
+        if (x < 0.0 || x > 1.0)
+            throw std::runtime_error("Error: quantiles() q = " + std::to_string(x) +
+                    " is outside [0, 1].");
+
+        result.push_back(detail::select_impl(comm, data, static_cast<long long>(x * (n - 1)),
+                    cmp));
+    } // Loop over quantiles
+
+    return result;
+}
+
+
+template <typename T>
+std::vector<T> quantiles(psrs::mpi_vector<T> &data, const std::vector<double> &q)
+{
+    return psrs::quantiles(data, q, std::less<T>());
+}
+
+
+}; // namespace psrs
+
+
+#endif
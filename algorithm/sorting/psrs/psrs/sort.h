@@ -12,77 +12,303 @@
 
 #include <boost/mpi/communicator.hpp>
 #include <boost/mpi/collectives.hpp>
+#include <boost/mpi/collectives/all_gatherv.hpp>
+#include <boost/mpi/timer.hpp>
 
 #include "mpi_vector.h"
 #include "all_to_allv.h"
+#include "parallel.h"
+#include "merge.h"
+#include "histogram.h"
+#include "sort_stats.h"
+#include "overlap.h"
+#include "hierarchical.h"
 
 
 namespace psrs {
+
+
+/* enum: partition_mode
+ *
+ * How psrs::sort() splits the data among procs.
+ * regular_sampling = pivots from p - 1 regular samples per proc (PSRS)
+ * histogram = iterative splitter refinement with ties broken by (value, rank, index). Bounds every
+ *             proc's share even with heavy duplicates.
+ */
+enum class partition_mode
+{
+    regular_sampling,
+    histogram
+};
+
+
+/* struct: sort_options
+ *
+ * Tuning options for psrs::sort(). Default values give the plain PSRS algorithm.
+ */
+struct sort_options
+{
+    // Max number of elements per message when exchanging types without an MPI_Datatype.
+    // 0 packs everything into a single MPI_Alltoallv.
+    int exchange_window = 0;
+
+    // Exchange std::string through Boost.Serialization instead of a flat char buffer.
+    bool serialize_strings = false;
+
+    // Number of threads each proc uses for the local sort, pivot partitioning and final merge.
+    int threads = 1;
+
+    // Partitioning method. For histogram partitioning, each bucket is refined until it is within
+    // tolerance * n / p elements of n / p, for at most max_refinements rounds.
+    partition_mode partition = partition_mode::regular_sampling;
+    double tolerance = 0.01;
+    int max_refinements = 32;
+
+    // Samples each proc offers for regular sampling. More samples give more even buckets at the
+    // cost of a larger sample exchange and merge. 0 takes p - 1, the classic PSRS choice.
+    int oversampling = 0;
+
+    // Keep equal elements in their original global order (rank, then local position). Set by
+    // psrs::stable_sort().
+    bool stable = false;
+
+    // Swap bucket sizes with MPI_Ialltoall, send buckets with point to point nonblocking messages
+    // and merge every incoming run as soon as it arrives. Only used for types with an
+    // MPI_Datatype, other types always use all_to_allv(). The merge runs on one thread.
+    bool overlap = false;
+
+    // Exchange buckets in two levels: gather to one leader per node, swap between leaders and
+    // scatter within each node. Nodes are the shared memory nodes found with MPI_Comm_split_type,
+    // or groups of ranks_per_group consecutive ranks when ranks_per_group > 0. Only used for types
+    // with an MPI_Datatype and ignored when overlap is set.
+    bool hierarchical = false;
+    int ranks_per_group = 0;
+};
+
+
 namespace detail {
 
 
+/* regular_sample_partition()
+ * @INPUT: comm = communicator
+ * @INPUT: data = locally sorted data
+ * @INPUT: cmp = comparator
+ * @INPUT: send_disp = output send displacements, must hold p elements
+ * @INPUT: oversampling = samples per proc. <= 0 takes p - 1
+ * @INPUT: threads = number of threads used to merge samples and partition
+ * @INPUT: radix_sorted = parallel_sort() radix sorted data
+ * @INPUT: timings = records sampling, broadcast and partition times
+ *
+ * Picks p - 1 pivots from regular samples of every proc and splits data at the pivots. Samples
+ * are taken from local data, so each proc's samples are already sorted. They are shared with an
+ * all_gatherv, and every proc merges the p sorted runs itself instead of proc 0 sorting all of
+ * them and broadcasting the pivots. broadcast records the all_gatherv.
+ */
 template <typename T, class Compare>
-void sort_mpi_type_impl(const boost::mpi::communicator &comm,
-        psrs::mpi_vector<T> &data, Compare cmp)
+void regular_sample_partition(const boost::mpi::communicator &comm,
+        const psrs::mpi_vector<T> &data, Compare cmp, std::vector<long long> &send_disp,
+        int oversampling, int threads, bool radix_sorted, sort_timings &timings)
 {
-    // Sort each proc's data
-    std::sort(data.begin(), data.end(), cmp);
+    boost::mpi::timer phase_timer;
+    int p = comm.size();
+    long long local_n = data.size();
+    int s = oversampling > 0 ? oversampling : p - 1;
 
-    // Get samples
+    // Evenly spaced samples. Procs with less data than samples offer what they have.
     std::vector<T> local_samples;
-    int p = comm.size();
-    int n = data.total_size();
+    for (int i = 0; i < s && i < local_n; i++)
+        local_samples.push_back(data[(2 * i + 1) * local_n / (2 * s)]);
 
-    for (int i = 0; i <= (p - 1) * (n / (p * p)); i += n / (p * p))
-        local_samples.push_back(data[i]);
+    timings.sampling = phase_timer.elapsed();
+    phase_timer.restart();
 
-    // Gather samples into proc 0
-    std::vector<T> samples;
-    boost::mpi::gather(comm, local_samples.data(), local_samples.size(), samples, 0);
+    std::vector<int> sample_cnt, sample_disp(p, 0);
+    boost::mpi::all_gather(comm, static_cast<int>(local_samples.size()), sample_cnt);
+    std::partial_sum(sample_cnt.begin(), sample_cnt.end() - 1, sample_disp.begin() + 1);
 
-    // Sort samples and determine pivots on proc 0. The broadecast pivots to all procs
-    std::vector<T> pivots;
-    if (!comm.rank()) {
-        std::sort(samples.begin(), samples.end(), cmp);
-        for (int i = p + (p / 2) - 1; i <= (p - 1) * p + (p / 2); i += p)
-            pivots.push_back(samples[i]);
-    }
+    std::vector<T> samples(sample_disp.back() + sample_cnt.back());
+    boost::mpi::all_gatherv(comm, local_samples, samples, sample_cnt);
+
+    timings.broadcast = phase_timer.elapsed();
+    phase_timer.restart();
+
+    if (samples.empty()) {
+        std::fill(send_disp.begin(), send_disp.end(), 0);
+        timings.partition = phase_timer.elapsed();
+        return;
+    } // No data anywhere
 
-    boost::mpi::broadcast(comm, pivots, 0);
+    // Merge the sorted runs and take p - 1 evenly spaced pivots
+    std::vector<std::pair<typename std::vector<T>::iterator,
+        typename std::vector<T>::iterator> > runs(p);
+    for (int i = 0; i < p; i++)
+        runs[i] = std::make_pair(samples.begin() + sample_disp[i],
+                samples.begin() + sample_disp[i] + sample_cnt[i]);
 
-    // Generate send displacement and count vectors for all to all
-    std::vector<int> send_disp(p), send_cnt(p);
+    std::vector<T> merged(samples.size());
+    detail::parallel_multiway_merge(runs, merged.begin(), cmp, threads);
+
+    std::vector<T> pivots;
+    for (long long i = 1; i < p; i++)
+        pivots.push_back(merged[i * merged.size() / p]);
+
+    timings.sampling += phase_timer.elapsed();
+    phase_timer.restart();
 
     // Generate displacements by creating partitions based on pivots
-    send_disp.front() = 0;
-    std::transform(pivots.begin(), pivots.end(), send_disp.begin() + 1,
-            [&data, &cmp](auto piv)->int {
-                auto it = std::lower_bound(data.begin(), data.end(), piv, cmp);
-                return std::distance(data.begin(), it);
-            });
+    detail::parallel_partition(data.begin(), data.end(), pivots, cmp, send_disp, threads,
+            radix_sorted);
+
+    timings.partition = phase_timer.elapsed();
+}
+
+
+/* split()
+ * @INPUT: comm = communicator
+ * @INPUT: data = locally sorted data
+ * @INPUT: cmp = comparator
+ * @INPUT: opts = tuning options
+ * @INPUT: radix_sorted = parallel_sort() radix sorted data
+ * @INPUT: send_cnt, send_disp = output count and displacement of every outgoing bucket
+ * @INPUT: timings = records sampling, broadcast and partition times
+ *
+ * Splits locally sorted data into p buckets with the partition method in opts.
+ */
+template <typename T, class Compare>
+void split(const boost::mpi::communicator &comm, const psrs::mpi_vector<T> &data, Compare cmp,
+        const sort_options &opts, bool radix_sorted, std::vector<long long> &send_cnt,
+        std::vector<long long> &send_disp,
+        sort_timings &timings)
+{
+    boost::mpi::timer phase_timer;
+    int p = comm.size();
+
+    send_disp.resize(p);
+    send_cnt.resize(p);
+
+    if (opts.partition == partition_mode::histogram) {
+        detail::histogram_partition(comm, data, cmp, send_disp, opts.tolerance,
+                opts.max_refinements);
+        timings.sampling = phase_timer.elapsed();
+    } else {
+        detail::regular_sample_partition(comm, data, cmp, send_disp, opts.oversampling,
+                opts.threads, radix_sorted, timings);
+    } // Splitter refinement is all counted as sampling
 
     // Compute count
-    std::adjacent_difference(send_disp.begin() + 1, send_disp.end() - 1, send_cnt.begin());
+    std::adjacent_difference(send_disp.begin() + 1, send_disp.end(), send_cnt.begin());
     send_cnt.back() = data.size() - send_disp.back();
+}
+
+
+/* split_counts()
+ * @INPUT: comm = communicator
+ * @INPUT: data = locally sorted data
+ * @INPUT: cmp = comparator
+ * @INPUT: opts = tuning options
+ * @INPUT: radix_sorted = parallel_sort() radix sorted data
+ * @INPUT: send_cnt, send_disp = output count and displacement of every outgoing bucket
+ * @INPUT: recv_cnt, recv_disp = output count and displacement of every incoming bucket
+ * @INPUT: timings = records sampling, broadcast, partition and count exchange times
+ *
+ * Splits locally sorted data into p buckets with split() and swaps the bucket sizes with every
+ * proc.
+ */
+template <typename T, class Compare>
+void split_counts(const boost::mpi::communicator &comm, const psrs::mpi_vector<T> &data,
+        Compare cmp, const sort_options &opts, bool radix_sorted, std::vector<long long> &send_cnt,
+        std::vector<long long> &send_disp, std::vector<long long> &recv_cnt,
+        std::vector<long long> &recv_disp,
+        sort_timings &timings)
+{
+    detail::split(comm, data, cmp, opts, radix_sorted, send_cnt, send_disp, timings);
+
+    boost::mpi::timer phase_timer;
 
     // Generate recv displacement and count vecor
-    std::vector<int> recv_disp, recv_cnt;
     boost::mpi::all_to_all(comm, send_cnt, recv_cnt);
 
-    recv_disp.resize(recv_cnt.size());
+    recv_disp.assign(recv_cnt.size(), 0);
     std::partial_sum(recv_cnt.begin(), recv_cnt.end() - 1, recv_disp.begin() + 1);
 
-    // Create temp vector to contain data.
-    std::vector<T> tmp;
+    timings.count_exchange = phase_timer.elapsed();
+}
 
-    // Perform an all to all data swap.
-    psrs::mpi::all_to_allv(comm, data.get_vector(), send_cnt, send_disp, tmp, recv_cnt, recv_disp);
 
-    // Perform final sort of data
-    std::sort(tmp.begin(), tmp.end(), cmp);
+template <typename T, class Compare>
+void sort_mpi_type_impl(const boost::mpi::communicator &comm,
+        psrs::mpi_vector<T> &data, Compare cmp, const sort_options &opts,
+        sort_timings &timings)
+{
+    boost::mpi::timer phase_timer;
+
+    // Sort each proc's data
+    bool radix_sorted = detail::parallel_sort(data.begin(), data.end(), cmp, opts.threads,
+            opts.stable);
 
-    // move tmp vector with data's internal vector.
-    data.move_vector(std::move(tmp));
+    timings.local_sort = phase_timer.elapsed();
+
+    int p = comm.size();
+    std::vector<long long> send_disp, send_cnt, recv_disp, recv_cnt;
+
+    if constexpr (boost::mpi::is_mpi_datatype<T>::value) {
+        if (opts.overlap) {
+            detail::split(comm, data, cmp, opts, radix_sorted, send_cnt, send_disp, timings);
+
+            psrs::mpi::xfer_size xfer = detail::overlapped_exchange_merge(comm, data, cmp,
+                    send_cnt, send_disp, timings);
+            timings.bytes_sent = xfer.sent;
+            timings.bytes_received = xfer.received;
+            timings.elements = data.size();
+            return;
+        }
+    } // Nonblocking exchange with the merge overlapped
+
+    detail::split_counts(comm, data, cmp, opts, radix_sorted, send_cnt, send_disp, recv_cnt,
+            recv_disp, timings);
+    phase_timer.restart();
+
+    // Perform an all to all data swap. Data is sent straight from data's storage and received
+    // into data's reusable buffer, which then becomes the local vector.
+    psrs::mpi::xfer_size xfer;
+    if constexpr (boost::mpi::is_mpi_datatype<T>::value) {
+        if (opts.hierarchical) {
+            const psrs::mpi::node_topology &topo = psrs::mpi::cached_node_topology(comm,
+                    opts.ranks_per_group);
+            xfer = psrs::mpi::all_to_allv_hierarchical(comm, topo, data.data(), send_cnt,
+                    send_disp, data.get_buffer(), recv_cnt, recv_disp);
+        } else {
+            xfer = psrs::mpi::all_to_allv(comm, data.data(), send_cnt, send_disp,
+                    data.get_buffer(), recv_cnt, recv_disp, opts.exchange_window);
+        } // Node aware or flat exchange
+    } else if (opts.serialize_strings) {
+        xfer = psrs::mpi::all_to_allv_serialized(comm, data.data(), send_cnt, send_disp,
+                data.get_buffer(), recv_cnt, recv_disp);
+    } else {
+        xfer = psrs::mpi::all_to_allv(comm, data.data(), send_cnt, send_disp,
+                data.get_buffer(), recv_cnt, recv_disp, opts.exchange_window);
+    }
+    data.swap_buffer();
+
+    timings.data_exchange = phase_timer.elapsed();
+    timings.bytes_sent = xfer.sent;
+    timings.bytes_received = xfer.received;
+    timings.elements = data.size();
+    phase_timer.restart();
+
+    // Each proc's portion is already sorted, so merge the p runs into the buffer. Runs are in
+    // source rank order and the merge keeps run order for equal elements, so it is stable.
+    std::vector<std::pair<typename psrs::mpi_vector<T>::iterator,
+        typename psrs::mpi_vector<T>::iterator> > runs(p);
+    for (int i = 0; i < p; i++)
+        runs[i] = std::make_pair(data.begin() + recv_disp[i],
+                data.begin() + recv_disp[i] + recv_cnt[i]);
+
+    data.get_buffer().resize(data.size());
+    detail::parallel_multiway_merge(runs, data.get_buffer().begin(), cmp, opts.threads);
+    data.swap_buffer();
+
+    timings.merge = phase_timer.elapsed();
 }
 
 
@@ -100,11 +326,12 @@ void sort(psrs::mpi_vector<T> &data)
 {
     // Special case: single proc
     if (data.get_comm().size() == 1) {
-        std::sort(data.begin(), data.end());
+        detail::parallel_sort(data.begin(), data.end(), std::less<T>(), 1);
         return;
     }
 
-    detail::sort_mpi_type_impl(data.get_comm(), data, std::less<T>());
+    detail::sort_timings timings;
+    detail::sort_mpi_type_impl(data.get_comm(), data, std::less<T>(), sort_options(), timings);
 }
 
 
@@ -120,11 +347,113 @@ void sort(psrs::mpi_vector<T> &data, Compare cmp)
 {
     // Special case: single proc
     if (data.get_comm().size() == 1) {
-        std::sort(data.begin(), data.end(), cmp);
+        detail::parallel_sort(data.begin(), data.end(), cmp, 1);
+        return;
+    }
+
+    detail::sort_timings timings;
+    detail::sort_mpi_type_impl(data.get_comm(), data, cmp, sort_options(), timings);
+}
+
+
+/* sort()
+ * @INPUT: data = data to sort
+ * @INPUT: cmp = comparator for sorting
+ * @INPUT: opts = tuning options
+ *
+ * Sort with callable comparator cmp and the given options.
+ */
+template <typename T, class Compare>
+void sort(psrs::mpi_vector<T> &data, Compare cmp, const sort_options &opts)
+{
+    // Special case: single proc
+    if (data.get_comm().size() == 1) {
+        detail::parallel_sort(data.begin(), data.end(), cmp, opts.threads, opts.stable);
         return;
     }
 
-    detail::sort_mpi_type_impl(data.get_comm(), data, cmp);
+    detail::sort_timings timings;
+    detail::sort_mpi_type_impl(data.get_comm(), data, cmp, opts, timings);
+}
+
+
+/* sort()
+ * @INPUT: data = data to sort
+ * @INPUT: cmp = comparator for sorting
+ * @INPUT: opts = tuning options
+ * @INPUT: psrs::instrument
+ *
+ * Same as sort(data, cmp, opts), but times every phase and counts the bytes and elements each
+ * proc ends up with. Returns the min/max/avg of each measurement across procs on every proc.
+ */
+template <typename T, class Compare>
+sort_stats sort(psrs::mpi_vector<T> &data, Compare cmp, const sort_options &opts, instrument_t)
+{
+    boost::mpi::timer total_timer;
+    detail::sort_timings timings;
+
+    // Special case: single proc
+    if (data.get_comm().size() == 1) {
+        detail::parallel_sort(data.begin(), data.end(), cmp, opts.threads, opts.stable);
+        timings.local_sort = total_timer.elapsed();
+    } else {
+        detail::sort_mpi_type_impl(data.get_comm(), data, cmp, opts, timings);
+    }
+
+    timings.total = total_timer.elapsed();
+    timings.elements = data.size();
+
+    return detail::reduce_timings(data.get_comm(), timings);
+}
+
+
+/* stable_sort()
+ * @INPUT: data = data to sort
+ * @INPUT: cmp = comparator for sorting. Default to std::less<T>
+ * @INPUT: opts = tuning options
+ *
+ * Same as sort(data, cmp, opts), but equal elements keep their original global order, ordered by
+ * rank and then by local position. Local sorts use std::stable_sort, and both partition methods
+ * and the final merge already keep that order.
+ */
+template <typename T, class Compare>
+void stable_sort(psrs::mpi_vector<T> &data, Compare cmp, sort_options opts)
+{
+    opts.stable = true;
+    psrs::sort(data, cmp, opts);
+}
+
+
+template <typename T, class Compare>
+void stable_sort(psrs::mpi_vector<T> &data, Compare cmp)
+{
+    psrs::stable_sort(data, cmp, sort_options());
+}
+
+
+template <typename T>
+void stable_sort(psrs::mpi_vector<T> &data)
+{
+    psrs::stable_sort(data, std::less<T>(), sort_options());
+}
+
+
+/* load_imbalance()
+ * @INPUT: data = distributed data
+ *
+ * Returns the largest proc's size divided by the average size. 1.0 is a perfect balance.
+ */
+template <typename T>
+double load_imbalance(const psrs::mpi_vector<T> &data)
+{
+    const boost::mpi::communicator comm = data.get_comm();
+    long long local_n = data.size();
+    long long max_n, n;
+
+    boost::mpi::all_reduce(comm, local_n, max_n, boost::mpi::maximum<long long>());
+    boost::mpi::all_reduce(comm, local_n, n, std::plus<long long>());
+
+    return n ? static_cast<double>(max_n) * comm.size() / n : 1.0;
 }
 
 
@@ -0,0 +1,163 @@
+/* Written by: Eric Tan
+ *
+ * Key value sorting for psrs. Records are split into a vector of keys and a vector of payloads.
+ * Only the keys are compared, sampled and partitioned. Payloads are permuted locally and follow
+ * their keys through the all to all exchange, so large records are moved but never compared.
+ */
+#ifndef SORT_BY_KEY_H
+#define SORT_BY_KEY_H
+
+#include <vector>
+#include <numeric>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/timer.hpp>
+
+#include "mpi_vector.h"
+#include "all_to_allv.h"
+#include "parallel.h"
+#include "merge.h"
+#include "sort.h"
+
+
+namespace psrs {
+namespace detail {
+
+
+/* apply_permutation()
+ * @INPUT: data = data to reorder
+ * @INPUT: perm = perm[i] is the index of the element that moves to position i
+ *
+ * Moves data[perm[i]] to position i through data's buffer.
+ */
+template <typename T>
+void apply_permutation(psrs::mpi_vector<T> &data, const std::vector<long long> &perm)
+{
+    std::vector<T> &out = data.get_buffer();
+
+    out.clear();
+    out.reserve(perm.size());
+    for (long long i : perm)
+        out.push_back(std::move(data[i]));
+
+    data.swap_buffer();
+}
+
+
+/* sort_by_key_impl()
+ * @INPUT: comm = communicator
+ * @INPUT: keys = keys to sort
+ * @INPUT: values = payloads, one per key
+ * @INPUT: cmp = key comparator
+ * @INPUT: opts = tuning options
+ * @INPUT: timings = per phase measurements
+ *
+ * PSRS on the keys. The local sort and the final merge produce a permutation of indices, which is
+ * applied to both keys and values. Keys and values are exchanged with the same counts and
+ * displacements.
+ */
+template <typename K, typename V, class Compare>
+void sort_by_key_impl(const boost::mpi::communicator &comm, psrs::mpi_vector<K> &keys,
+        psrs::mpi_vector<V> &values, Compare cmp, const sort_options &opts,
+        sort_timings &timings)
+{
+    boost::mpi::timer phase_timer;
+    std::vector<long long> perm(keys.size());
+
+    auto idx_cmp = [&keys, &cmp](long long a, long long b) { return cmp(keys[a], keys[b]); };
+
+    // Sort indices by key. Always stable, so equal keys keep their order.
+    std::iota(perm.begin(), perm.end(), 0LL);
+    detail::parallel_sort(perm.begin(), perm.end(), idx_cmp, opts.threads, true);
+    detail::apply_permutation(keys, perm);
+    detail::apply_permutation(values, perm);
+
+    timings.local_sort = phase_timer.elapsed();
+
+    int p = comm.size();
+    std::vector<long long> send_disp, send_cnt, recv_disp, recv_cnt;
+
+    // Keys were reordered by a comparison sort of indices, never radix sorted
+    detail::split_counts(comm, keys, cmp, opts, false, send_cnt, send_disp, recv_cnt,
+            recv_disp, timings);
+    phase_timer.restart();
+
+    // Keys and payloads move with the same counts and displacements
+    psrs::mpi::xfer_size key_xfer = psrs::mpi::all_to_allv(comm, keys.data(), send_cnt,
+            send_disp, keys.get_buffer(), recv_cnt, recv_disp, opts.exchange_window);
+    psrs::mpi::xfer_size value_xfer = psrs::mpi::all_to_allv(comm, values.data(), send_cnt,
+            send_disp, values.get_buffer(), recv_cnt, recv_disp, opts.exchange_window);
+    keys.swap_buffer();
+    values.swap_buffer();
+
+    timings.data_exchange = phase_timer.elapsed();
+    timings.bytes_sent = key_xfer.sent + value_xfer.sent;
+    timings.bytes_received = key_xfer.received + value_xfer.received;
+    timings.elements = keys.size();
+    phase_timer.restart();
+
+    // Merge the p runs of indices by key, then apply the merged order
+    std::vector<long long> idx(keys.size());
+    std::iota(idx.begin(), idx.end(), 0LL);
+    perm.resize(keys.size());
+
+    std::vector<std::pair<std::vector<long long>::iterator,
+        std::vector<long long>::iterator> > runs(p);
+    for (int i = 0; i < p; i++)
+        runs[i] = std::make_pair(idx.begin() + recv_disp[i],
+                idx.begin() + recv_disp[i] + recv_cnt[i]);
+
+    detail::parallel_multiway_merge(runs, perm.begin(), idx_cmp, opts.threads);
+    detail::apply_permutation(keys, perm);
+    detail::apply_permutation(values, perm);
+
+    timings.merge = phase_timer.elapsed();
+}
+
+
+}; // namespace detail
+
+
+/* sort_by_key()
+ * @INPUT: keys = keys to sort
+ * @INPUT: values = payloads, values[i] belongs to keys[i]
+ * @INPUT: cmp = key comparator. Default to std::less<K>
+ * @INPUT: opts = tuning options
+ *
+ * Sorts keys across all procs and moves every value along with its key. Only keys are compared,
+ * sampled and partitioned. The sort is stable: equal keys keep their original global order.
+ * Throws std::runtime_error if keys and values have different local sizes.
+ */
+template <typename K, typename V, class Compare>
+void sort_by_key(psrs::mpi_vector<K> &keys, psrs::mpi_vector<V> &values, Compare cmp,
+        const sort_options &opts)
+{
+    if (keys.size() != values.size())
+        throw std::runtime_error("Error: sort_by_key() keys and values have different sizes.");
+
+    detail::sort_timings timings;
+    detail::sort_by_key_impl(keys.get_comm(), keys, values, cmp, opts, timings);
+}
+
+
+template <typename K, typename V, class Compare>
+void sort_by_key(psrs::mpi_vector<K> &keys, psrs::mpi_vector<V> &values, Compare cmp)
+{
+    psrs::sort_by_key(keys, values, cmp, sort_options());
+}
+
+
+template <typename K, typename V>
+void sort_by_key(psrs::mpi_vector<K> &keys, psrs::mpi_vector<V> &values)
+{
+    psrs::sort_by_key(keys, values, std::less<K>(), sort_options());
+}
+
+
+}; // namespace psrs
+
+
+#endif
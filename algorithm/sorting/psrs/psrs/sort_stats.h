@@ -0,0 +1,124 @@
+/* Written by: Eric Tan
+ *
+ * Per phase instrumentation for psrs::sort.
+ */
+#ifndef SORT_STATS_H
+#define SORT_STATS_H
+
+#include <vector>
+
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/operations.hpp>
+
+
+namespace psrs {
+
+
+/* struct: phase_stat
+ *
+ * Min, max and average of a quantity across all procs.
+ */
+struct phase_stat
+{
+    double min = 0.0;
+    double max = 0.0;
+    double avg = 0.0;
+};
+
+
+/* struct: sort_stats
+ *
+ * Statistics returned by the instrumented psrs::sort(). Times are in seconds. Phases are not
+ * separated by barriers, so time spent waiting on other procs shows up in the phase that waits.
+ * Bytes only count data sent to or received from other procs in the data exchange.
+ */
+struct sort_stats
+{
+    phase_stat local_sort;
+    phase_stat sampling;
+    phase_stat broadcast;
+    phase_stat partition;
+    phase_stat count_exchange;
+    phase_stat data_exchange;
+    phase_stat merge;
+    phase_stat total;
+    phase_stat bytes_sent;
+    phase_stat bytes_received;
+    phase_stat elements;
+};
+
+
+/* struct: instrument_t
+ *
+ * Tag type selecting the instrumented psrs::sort() overload. Use psrs::instrument.
+ */
+struct instrument_t
+{
+};
+
+constexpr instrument_t instrument{};
+
+
+namespace detail {
+
+
+/* struct: sort_timings
+ *
+ * A single proc's measurements. Filled in by sort_mpi_type_impl.
+ */
+struct sort_timings
+{
+    double local_sort = 0.0;
+    double sampling = 0.0;
+    double broadcast = 0.0;
+    double partition = 0.0;
+    double count_exchange = 0.0;
+    double data_exchange = 0.0;
+    double merge = 0.0;
+    double total = 0.0;
+    long long bytes_sent = 0;
+    long long bytes_received = 0;
+    long long elements = 0;
+};
+
+
+/* reduce_timings()
+ * @INPUT: comm = communicator
+ * @INPUT: t = this proc's measurements
+ *
+ * Reduces every proc's measurements into min/max/avg. Result is returned on all procs.
+ */
+inline sort_stats reduce_timings(const boost::mpi::communicator &comm, const sort_timings &t)
+{
+    std::vector<double> local = {t.local_sort, t.sampling, t.broadcast, t.partition,
+        t.count_exchange, t.data_exchange, t.merge, t.total, static_cast<double>(t.bytes_sent),
+        static_cast<double>(t.bytes_received), static_cast<double>(t.elements)};
+    std::vector<double> lo(local.size()), hi(local.size()), sum(local.size());
+
+    boost::mpi::all_reduce(comm, local.data(), local.size(), lo.data(),
+            boost::mpi::minimum<double>());
+    boost::mpi::all_reduce(comm, local.data(), local.size(), hi.data(),
+            boost::mpi::maximum<double>());
+    boost::mpi::all_reduce(comm, local.data(), local.size(), sum.data(), std::plus<double>());
+
+    sort_stats stats;
+    phase_stat *fields[] = {&stats.local_sort, &stats.sampling, &stats.broadcast,
+        &stats.partition, &stats.count_exchange, &stats.data_exchange, &stats.merge,
+        &stats.total, &stats.bytes_sent, &stats.bytes_received, &stats.elements};
+
+    for (std::size_t i = 0; i < local.size(); i++) {
+        fields[i]->min = lo[i];
+        fields[i]->max = hi[i];
+        fields[i]->avg = sum[i] / comm.size();
+    } // Fill in stats
+
+    return stats;
+}
+
+
+}; // namespace detail
+}; // namespace psrs
+
+
+#endif
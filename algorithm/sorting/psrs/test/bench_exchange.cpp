@@ -0,0 +1,108 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <sys/resource.h>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/timer.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/mpi_utility.h"
+#include "../psrs/all_to_allv.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/* peak_rss()
+ * Returns the peak resident set size of the process in KB.
+ */
+long peak_rss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+
+/* Benchmark for the all to all exchange in psrs::sort. Compares copying the local vector and
+ * receiving into a new vector (copy) against sending from the mpi_vector storage and receiving
+ * into its reusable buffer (direct). Peak RSS only grows, so each mode is run as its own job:
+ *
+ *     mpirun -np 4 ./bench_exchange.out 10000000 copy
+ *     mpirun -np 4 ./bench_exchange.out 10000000 direct
+ */
+int main(int argc, char **argv)
+{
+    mpi::environment env(argc, argv);
+    mpi::communicator comm;
+
+    int N = (argc >= 2) ? atoi(argv[1]) : 10000000;
+    std::string mode = (argc >= 3) ? argv[2] : "direct";
+    int iters = (argc >= 4) ? atoi(argv[3]) : 5;
+    int p = comm.size();
+    int id = comm.rank();
+
+    if (mode != "copy" && mode != "direct") {
+        if (!id)
+            std::cerr << "Error: mode must be copy or direct.\n";
+        return EXIT_FAILURE;
+    }
+
+    // Generate each proc's block directly to keep proc 0 from holding all of the data
+    std::mt19937 engine(id);
+    std::uniform_real_distribution<double> range(-100.0, 100.0);
+    psrs::mpi_vector<double> v(comm);
+    v.resize(psrs::utility::blk_size(id, p, N));
+    std::generate(v.begin(), v.end(), [&range, &engine]()->double { return range(engine); });
+
+    long base_rss = peak_rss();
+
+    mpi::timer exchange_timer;
+    for (int it = 0; it < iters; it++) {
+        // Each proc sends an even share of its block to every proc
+        int local_n = v.size();
+        std::vector<int> send_cnt(p), send_disp(p), recv_cnt, recv_disp(p);
+        for (int i = 0; i < p; i++) {
+            send_disp[i] = psrs::utility::blk_low(i, p, local_n);
+            send_cnt[i] = psrs::utility::blk_size(i, p, local_n);
+        }
+
+        mpi::all_to_all(comm, send_cnt, recv_cnt);
+        for (int i = 1; i < p; i++)
+            recv_disp[i] = recv_disp[i - 1] + recv_cnt[i - 1];
+
+        if (mode == "copy") {
+            std::vector<double> local(v.begin(), v.end());
+            std::vector<double> tmp;
+            psrs::mpi::all_to_allv(comm, local, send_cnt, send_disp, tmp, recv_cnt, recv_disp);
+            v.move_vector(std::move(tmp));
+        } else {
+            psrs::mpi::all_to_allv(comm, v.data(), send_cnt, send_disp, v.get_buffer(),
+                    recv_cnt, recv_disp);
+            v.swap_buffer();
+        } // Exchange with selected mode
+    } // Loop over iterations
+    double elapsed = exchange_timer.elapsed() / iters;
+
+    long rss = peak_rss();
+    long max_base, max_rss;
+    double max_time;
+    mpi::reduce(comm, base_rss, max_base, mpi::maximum<long>(), 0);
+    mpi::reduce(comm, rss, max_rss, mpi::maximum<long>(), 0);
+    mpi::reduce(comm, elapsed, max_time, mpi::maximum<double>(), 0);
+
+    if (!id) {
+        std::cout << "Exchange mode: " << mode << " (N = " << N << ", p = " << p << ")\n";
+        std::cout << "Time per exchange: " << max_time << "s\n";
+        std::cout << "Peak RSS before exchange: " << max_base << " KB\n";
+        std::cout << "Peak RSS after exchange: " << max_rss << " KB (+"
+            << max_rss - max_base << " KB)\n";
+    }
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <cstdio>
+#include <filesystem>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/mpi_utility.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_round_trip(const mpi::communicator &comm, const std::string &path);
+void test_type_mismatch(const mpi::communicator &comm, const std::string &path);
+void test_truncated(const mpi::communicator &comm, const std::string &path);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    try {
+        mpi::environment env;
+        mpi::communicator comm;
+        std::string path = "binary_io_test.bin";
+
+        test_round_trip(comm, path);
+        test_type_mismatch(comm, path);
+        test_truncated(comm, path);
+
+        comm.barrier();
+        if (!comm.rank())
+            std::remove(path.c_str());
+    } catch (std::exception &e) {
+        std::cout << "Exception caught: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cout << "Unknown exception caught in main()" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_round_trip(const mpi::communicator &comm, const std::string &path)
+{
+    int N = 1000;
+    int p = comm.size();
+    int id = comm.rank();
+    std::vector<double> data(N);
+
+    std::iota(data.begin(), data.end(), 0.5);
+
+    // Give every proc an uneven piece so write_binary() has to compute offsets
+    int low = (id * id) * N / (p * p);
+    int high = ((id + 1) * (id + 1)) * N / (p * p);
+    psrs::mpi_vector<double> v(comm);
+    v.assign(data.begin() + low, data.begin() + high);
+
+    v.write_binary(path);
+
+    psrs::mpi_vector<double> w(comm);
+    w.read_binary(path);
+
+    int start = psrs::utility::blk_low(id, p, N);
+    int local_n = psrs::utility::blk_size(id, p, N);
+
+    // Test block size
+    if (local_n != static_cast<int>(w.size()))
+        throw std::runtime_error("Error: read_binary() in test_round_trip().\n"
+                "Expected local_n and w.size() to be equal on proc " + std::to_string(id) + ".\n" +
+                "local_n = " + std::to_string(local_n) + " w.size() = " + std::to_string(w.size()));
+
+    // Test block data
+    if (!std::equal(w.begin(), w.end(), data.begin() + start))
+        throw std::runtime_error("Error: read_binary() in test_round_trip().\nExpected proc " +
+                std::to_string(id) + " data to match its block.");
+}
+
+
+void test_type_mismatch(const mpi::communicator &comm, const std::string &path)
+{
+    psrs::mpi_vector<int> v(comm);
+
+    try {
+        v.read_binary(path);
+    } catch (std::runtime_error &) {
+        return;
+    }
+
+    throw std::runtime_error("Error: read_binary() in test_type_mismatch().\n"
+            "Expected an exception on proc " + std::to_string(comm.rank()) + '.');
+}
+
+
+void test_truncated(const mpi::communicator &comm, const std::string &path)
+{
+    // Cut the data short, then cut into the header
+    for (std::uintmax_t size : {16 + 500 * sizeof(double), std::uintmax_t(10)}) {
+        comm.barrier();
+        if (!comm.rank())
+            std::filesystem::resize_file(path, size);
+        comm.barrier();
+
+        psrs::mpi_vector<double> v(comm);
+        bool thrown = false;
+
+        try {
+            v.read_binary(path);
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+
+        if (!thrown)
+            throw std::runtime_error("Error: read_binary() in test_truncated().\n"
+                    "Expected an exception for a " + std::to_string(size) + " byte file on proc " +
+                    std::to_string(comm.rank()) + '.');
+    } // Loop over file sizes
+}
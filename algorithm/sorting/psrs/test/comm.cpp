@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include <numeric>
+#include <list>
 
 #include <boost/mpi/environment.hpp>
 #include <boost/mpi/communicator.hpp>
@@ -20,6 +21,8 @@ namespace mpi = boost::mpi;
  *-----------------------------------------------------------------------------------------------*/
 void test_int(const mpi::communicator &comm);
 void test_string(const mpi::communicator &comm);
+void test_list(const mpi::communicator &comm);
+void test_rebalance(const mpi::communicator &comm);
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -33,6 +36,8 @@ int main(void)
 
         test_int(comm);
         test_string(comm);
+        test_list(comm);
+        test_rebalance(comm);
     } catch (std::exception &e) {
         std::cout << "Exception caught: " << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -160,3 +165,83 @@ void test_string(const mpi::communicator &comm)
         throw std::runtime_error("Error: scatter() in test_string().\n"
                 "Expected data to be equally scattered on proc " + std::to_string(id) + '.');
 }
+
+
+void test_list(const mpi::communicator &comm)
+{
+    int N = 101;
+    int p = comm.size();
+    int id = comm.rank();
+    int root = p - 1;
+    std::list<double> data;
+
+    // Non contiguous range, so distribute() has to stage the data
+    for (int i = 0; i < N; i++)
+        data.push_back(0.5 * i);
+
+    psrs::mpi_vector<double> v(comm);
+
+    // Distribute from the last proc
+    v.distribute(data.begin(), data.end(), root);
+
+    int local_n = psrs::utility::blk_size(id, p, N);
+    int start = psrs::utility::blk_low(id, p, N);
+
+    // Test size of distributed vector
+    if (local_n != v.size())
+        throw std::runtime_error("Error: distribute() in test_list().\n"
+                "Expected local_n and v.size() to be equal on proc " + std::to_string(id) + ".\n" +
+                "local_n = " + std::to_string(local_n) + " v.size() = " + std::to_string(v.size()));
+
+    // Test vector data
+    if (!std::equal(v.begin(), v.end(), std::next(data.begin(), start)))
+        throw std::runtime_error("Error: distribute() in test_list().\nExpected proc " +
+                std::to_string(id) + " data to match its block.");
+
+    // Already block distributed, so scatter() should leave everything in place
+    v.scatter();
+    if (local_n != v.size() || !std::equal(v.begin(), v.end(), std::next(data.begin(), start)))
+        throw std::runtime_error("Error: scatter() in test_list().\nExpected proc " +
+                std::to_string(id) + " data to be unchanged.");
+
+    // Gather to the last proc and scatter back out
+    v.gather(root);
+    v.scatter();
+    if (local_n != v.size() || !std::equal(v.begin(), v.end(), std::next(data.begin(), start)))
+        throw std::runtime_error("Error: gather() and scatter() in test_list().\nExpected proc " +
+                std::to_string(id) + " data to match its block.");
+}
+
+
+void test_rebalance(const mpi::communicator &comm)
+{
+    int N = 200;
+    int p = comm.size();
+    int id = comm.rank();
+    std::vector<std::string> data(N);
+
+    for (int i = 0; i < N; i++)
+        data[i] = std::to_string(1000 + i);
+
+    // Skewed pieces, the last proc holds most of the data
+    int low = (id * id) * N / (p * p);
+    int high = ((id + 1) * (id + 1)) * N / (p * p);
+    psrs::mpi_vector<std::string> v(comm);
+    v.assign(data.begin() + low, data.begin() + high);
+
+    v.rebalance();
+
+    int local_n = psrs::utility::blk_size(id, p, N);
+    int start = psrs::utility::blk_low(id, p, N);
+
+    // Test size of rebalanced vector
+    if (local_n != v.size())
+        throw std::runtime_error("Error: rebalance() in test_rebalance().\n"
+                "Expected local_n and v.size() to be equal on proc " + std::to_string(id) + ".\n" +
+                "local_n = " + std::to_string(local_n) + " v.size() = " + std::to_string(v.size()));
+
+    // Test global order is kept
+    if (!std::equal(v.begin(), v.end(), data.begin() + start))
+        throw std::runtime_error("Error: rebalance() in test_rebalance().\nExpected proc " +
+                std::to_string(id) + " data to match its block.");
+}
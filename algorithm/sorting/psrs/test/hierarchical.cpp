@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <random>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/collectives.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/all_to_allv.h"
+#include "../psrs/hierarchical.h"
+#include "../psrs/sort.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_exchange(const mpi::communicator &comm, int ranks_per_group);
+void test_sort(const mpi::communicator &comm, int ranks_per_group);
+void test_cache(const mpi::communicator &comm);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    try {
+        mpi::environment env;
+        mpi::communicator comm;
+
+        // 0 uses the real nodes, the rest emulate nodes of that many ranks
+        for (int group : {0, 1, 2, 3, comm.size()}) {
+            test_exchange(comm, group);
+            test_sort(comm, group);
+        } // Loop over group sizes
+
+        test_cache(comm);
+    } catch (std::exception &e) {
+        std::cout << "Exception caught: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cout << "Unknown exception caught in main()" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_exchange(const mpi::communicator &comm, int ranks_per_group)
+{
+    int p = comm.size();
+    int id = comm.rank();
+    std::mt19937 engine(id + 7);
+    std::vector<long long> send_cnt(p), send_disp(p), recv_cnt(p), recv_disp(p, 0);
+
+    // Random bucket sizes, some empty, with a gap before every bucket
+    std::vector<long> values;
+    for (int i = 0; i < p; i++) {
+        send_cnt[i] = (engine() % 4) ? engine() % 100 : 0;
+        values.resize(values.size() + engine() % 3);
+        send_disp[i] = values.size();
+        for (int j = 0; j < send_cnt[i]; j++)
+            values.push_back(1000000L * id + 1000L * i + j);
+    } // Loop over procs
+
+    mpi::all_to_all(comm, send_cnt, recv_cnt);
+    std::partial_sum(recv_cnt.begin(), recv_cnt.end() - 1, recv_disp.begin() + 1);
+
+    psrs::mpi::node_topology topo = psrs::mpi::make_node_topology(comm, ranks_per_group);
+    std::vector<long> flat, two_level;
+
+    psrs::mpi::all_to_allv(comm, values.data(), send_cnt, send_disp, flat, recv_cnt, recv_disp);
+    psrs::mpi::all_to_allv_hierarchical(comm, topo, values.data(), send_cnt, send_disp,
+            two_level, recv_cnt, recv_disp);
+
+    if (flat != two_level)
+        throw std::runtime_error("Error: all_to_allv_hierarchical() with " +
+                std::to_string(ranks_per_group) + " ranks per group.\nProc " +
+                std::to_string(id) + " received different data than all_to_allv().");
+
+    // Output with gaps between the blocks
+    std::vector<long long> spread_disp(p);
+    for (int i = 0; i < p; i++)
+        spread_disp[i] = recv_disp[i] + 2 * i;
+
+    psrs::mpi::all_to_allv_hierarchical(comm, topo, values.data(), send_cnt, send_disp,
+            two_level, recv_cnt, spread_disp);
+    for (int i = 0; i < p; i++) {
+        if (!std::equal(flat.begin() + recv_disp[i], flat.begin() + recv_disp[i] + recv_cnt[i],
+                    two_level.begin() + spread_disp[i]))
+            throw std::runtime_error("Error: all_to_allv_hierarchical() with " +
+                    std::to_string(ranks_per_group) + " ranks per group.\nProc " +
+                    std::to_string(id) + " misplaced the block from proc " + std::to_string(i) +
+                    '.');
+    } // Loop over procs
+}
+
+
+void test_sort(const mpi::communicator &comm, int ranks_per_group)
+{
+    std::mt19937 engine(11);
+    std::vector<double> values(100000);
+
+    for (auto &x : values)
+        x = std::uniform_real_distribution<double>(-1.0, 1.0)(engine);
+
+    psrs::mpi_vector<double> v(comm, values.begin(), values.end(), 0);
+    psrs::sort_options opts;
+    opts.hierarchical = true;
+    opts.ranks_per_group = ranks_per_group;
+
+    psrs::sort(v, std::less<double>(), opts);
+    v.gather(0);
+
+    if (!comm.rank()) {
+        std::sort(values.begin(), values.end());
+        if (!std::equal(v.begin(), v.end(), values.begin(), values.end()))
+            throw std::runtime_error("Error: test_sort() with " +
+                    std::to_string(ranks_per_group) + " ranks per group.\nData not sorted.");
+    }
+}
+
+
+void test_cache(const mpi::communicator &comm)
+{
+    const psrs::mpi::node_topology &first = psrs::mpi::cached_node_topology(comm, 2);
+    const psrs::mpi::node_topology &second = psrs::mpi::cached_node_topology(comm, 2);
+
+    if (&first != &second)
+        throw std::runtime_error("Error: cached_node_topology() in test_cache().\n"
+                "Expected the same topology for the same group size on proc " +
+                std::to_string(comm.rank()) + '.');
+
+    // A duplicate communicator gets its own topology, freed along with it
+    mpi::communicator dup(comm, mpi::comm_duplicate);
+    const psrs::mpi::node_topology &other = psrs::mpi::cached_node_topology(dup, 2);
+
+    if (&other == &first || other.members != first.members)
+        throw std::runtime_error("Error: cached_node_topology() in test_cache().\n"
+                "Expected a separate but equal topology for a duplicate communicator on proc " +
+                std::to_string(comm.rank()) + '.');
+}
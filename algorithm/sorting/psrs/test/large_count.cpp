@@ -0,0 +1,242 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <random>
+#include <cstdio>
+#include <mpi.h>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/collectives.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/large_count.h"
+#include "../psrs/all_to_allv.h"
+#include "../psrs/sort.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_large_type();
+void test_exchange(const mpi::communicator &comm);
+void test_strings(const mpi::communicator &comm);
+void test_serialized(const mpi::communicator &comm);
+void test_vector(const mpi::communicator &comm);
+void test_sort(const mpi::communicator &comm);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    try {
+        mpi::environment env;
+        mpi::communicator comm;
+
+        test_large_type();
+
+        // Emulate counts past 2^31 by lowering the limit, so every block takes the large path
+        psrs::mpi::large_count_limit = 7;
+
+        test_large_type();
+        test_exchange(comm);
+        test_strings(comm);
+        test_serialized(comm);
+        test_vector(comm);
+        test_sort(comm);
+    } catch (std::exception &e) {
+        std::cout << "Exception caught: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cout << "Unknown exception caught in main()" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_large_type()
+{
+    // Only the type is built, nothing is allocated
+    for (long long count : {0LL, 1LL, 1000LL, 3000000000LL, 3000000007LL}) {
+        MPI_Datatype type = psrs::mpi::make_large_type(count, MPI_CHAR);
+        MPI_Count size, lb, extent;
+
+        MPI_Type_size_x(type, &size);
+        MPI_Type_get_extent_x(type, &lb, &extent);
+        MPI_Type_free(&type);
+
+        if (size != count || extent != count || lb != 0)
+            throw std::runtime_error("Error: make_large_type() in test_large_type().\n"
+                    "Wrong size or extent for count " + std::to_string(count) + " with limit " +
+                    std::to_string(psrs::mpi::large_count_limit) + '.');
+    } // Loop over counts
+}
+
+
+void test_exchange(const mpi::communicator &comm)
+{
+    int p = comm.size();
+    int id = comm.rank();
+    std::mt19937 engine(id + 1);
+    std::vector<long long> send_cnt(p), send_disp(p), recv_cnt(p), recv_disp(p, 0);
+
+    // Small element type, blocks both below and above the limit
+    std::vector<char> values;
+    for (int i = 0; i < p; i++) {
+        send_cnt[i] = engine() % 40;
+        send_disp[i] = values.size();
+        for (int j = 0; j < send_cnt[i]; j++)
+            values.push_back(static_cast<char>('a' + (id + i + j) % 26));
+    } // Loop over procs
+
+    mpi::all_to_all(comm, send_cnt, recv_cnt);
+    std::partial_sum(recv_cnt.begin(), recv_cnt.end() - 1, recv_disp.begin() + 1);
+
+    std::vector<char> out;
+    psrs::mpi::all_to_allv(comm, values.data(), send_cnt, send_disp, out, recv_cnt, recv_disp);
+
+    for (int i = 0; i < p; i++)
+        for (int j = 0; j < recv_cnt[i]; j++)
+            if (out[recv_disp[i] + j] != static_cast<char>('a' + (i + id + j) % 26))
+                throw std::runtime_error("Error: all_to_allv() in test_exchange().\nProc " +
+                        std::to_string(id) + " received a wrong value from proc " +
+                        std::to_string(i) + '.');
+}
+
+
+void test_strings(const mpi::communicator &comm)
+{
+    int p = comm.size();
+    int id = comm.rank();
+    std::vector<long long> send_cnt(p, 3), send_disp(p), recv_cnt(p, 3), recv_disp(p);
+    std::vector<std::string> words;
+
+    // The last string sent to the last proc is empty
+    for (int i = 0; i < p; i++) {
+        send_disp[i] = recv_disp[i] = 3 * i;
+        for (int j = 0; j < 3; j++)
+            words.push_back(std::string(5 * (2 - j) + p - 1 - i, 'a' + id));
+    } // Loop over procs
+
+    std::vector<std::string> out;
+    psrs::mpi::all_to_allv(comm, words.data(), send_cnt, send_disp, out, recv_cnt, recv_disp);
+
+    for (int i = 0; i < p; i++)
+        for (int j = 0; j < 3; j++)
+            if (out[3 * i + j] != std::string(5 * (2 - j) + p - 1 - id, 'a' + i))
+                throw std::runtime_error("Error: all_to_allv() in test_strings().\nProc " +
+                        std::to_string(id) + " received a wrong string from proc " +
+                        std::to_string(i) + '.');
+}
+
+
+void test_serialized(const mpi::communicator &comm)
+{
+    int p = comm.size();
+    int id = comm.rank();
+    std::vector<long long> send_cnt(p, 2), send_disp(p), recv_cnt(p, 2), recv_disp(p);
+    std::vector<std::vector<int> > rows;
+
+    // Serialized through packed archives, with more bytes per proc than large_count_limit
+    for (int i = 0; i < p; i++) {
+        send_disp[i] = recv_disp[i] = 2 * i;
+        for (int j = 0; j < 2; j++)
+            rows.push_back(std::vector<int>(3 + j, 100 * id + i));
+    } // Loop over procs
+
+    std::vector<std::vector<int> > out;
+    psrs::mpi::all_to_allv(comm, rows.data(), send_cnt, send_disp, out, recv_cnt, recv_disp);
+
+    for (int i = 0; i < p; i++)
+        for (int j = 0; j < 2; j++)
+            if (out[2 * i + j] != std::vector<int>(3 + j, 100 * i + id))
+                throw std::runtime_error("Error: all_to_allv() in test_serialized().\nProc " +
+                        std::to_string(id) + " received a wrong vector from proc " +
+                        std::to_string(i) + '.');
+
+    // Blocks of serialized values longer than large_count_limit go in several messages
+    std::vector<std::string> words(100);
+    for (int i = 0; i < 100; i++)
+        words[i] = std::to_string(i);
+
+    psrs::mpi_vector<std::string> v(comm, words.begin(), words.end(), 0);
+    v.gather(p - 1);
+    v.scatter();
+    v.gather(0);
+
+    if (!comm.rank() && !std::equal(v.begin(), v.end(), words.begin(), words.end()))
+        throw std::runtime_error("Error: test_serialized().\nStrings out of order after "
+                "gather() and scatter().");
+}
+
+
+void test_vector(const mpi::communicator &comm)
+{
+    int N = 1000;
+    std::vector<short> data(N);
+    for (int i = 0; i < N; i++)
+        data[i] = i;
+
+    psrs::mpi_vector<short> v(comm, data.begin(), data.end(), comm.size() - 1);
+
+    // Uneven sizes so rebalance() moves data
+    if (comm.rank() % 2)
+        v.resize(v.size() / 2);
+
+    v.gather(0);
+    v.scatter();
+    v.rebalance();
+
+    std::string path = "large_count_test.bin";
+    v.write_binary(path);
+    v.read_binary(path);
+    v.gather(0);
+
+    comm.barrier();
+    if (!comm.rank()) {
+        std::remove(path.c_str());
+
+        for (std::size_t i = 0; i < v.size(); i++)
+            if (v[i] > N || (i && v[i] <= v[i - 1]))
+                throw std::runtime_error("Error: test_vector().\nData out of order at " +
+                        std::to_string(i) + '.');
+    }
+}
+
+
+void test_sort(const mpi::communicator &comm)
+{
+    std::mt19937 engine(2);
+    std::vector<unsigned char> data(20000);
+
+    for (auto &x : data)
+        x = engine() % 256;
+
+    std::vector<unsigned char> sorted(data);
+    std::sort(sorted.begin(), sorted.end());
+
+    for (int variant = 0; variant < 3; variant++) {
+        psrs::mpi_vector<unsigned char> v(comm, data.begin(), data.end(), 0);
+        psrs::sort_options opts;
+        opts.overlap = variant == 1;
+        opts.hierarchical = variant == 2;
+        opts.ranks_per_group = 2;
+
+        psrs::sort(v, std::less<unsigned char>(), opts);
+        v.gather(0);
+
+        if (!comm.rank() && !std::equal(v.begin(), v.end(), sorted.begin(), sorted.end()))
+            throw std::runtime_error("Error: test_sort() variant " + std::to_string(variant) +
+                    ".\nData not sorted.");
+    } // Loop over exchange variants
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <random>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/sort.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+template <typename T>
+void test_sampling(const mpi::communicator &comm, std::vector<T> data, int oversampling);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    try {
+        mpi::environment env;
+        mpi::communicator comm;
+        std::mt19937 engine(5);
+
+        // Sizes below p * p used to hang the sampling loop
+        for (int n : {0, 1, 2, comm.size() * comm.size() - 1, 1000, 100000}) {
+            std::vector<int> ints(n);
+            std::vector<std::string> words(n / 10);
+
+            for (auto &x : ints)
+                x = engine() % 1000;
+            for (auto &x : words)
+                x = std::to_string(engine() % 1000);
+
+            for (int oversampling : {0, 1, 64}) {
+                test_sampling(comm, ints, oversampling);
+                test_sampling(comm, words, oversampling);
+            } // Loop over oversampling factors
+        } // Loop over sizes
+    } catch (std::exception &e) {
+        std::cout << "Exception caught: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cout << "Unknown exception caught in main()" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+template <typename T>
+void test_sampling(const mpi::communicator &comm, std::vector<T> data, int oversampling)
+{
+    psrs::mpi_vector<T> v(comm, data.begin(), data.end(), 0);
+    psrs::sort_options opts;
+    opts.oversampling = oversampling;
+
+    psrs::sort(v, std::less<T>(), opts);
+    v.gather(0);
+
+    if (!comm.rank()) {
+        std::sort(data.begin(), data.end());
+        if (!std::equal(v.begin(), v.end(), data.begin(), data.end()))
+            throw std::runtime_error("Error: test_sampling() with " +
+                    std::to_string(data.size()) + " elements and oversampling " +
+                    std::to_string(oversampling) + ".\nData not sorted.");
+    }
+}
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <random>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/select.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+template <typename T, class Compare>
+void test_select(const mpi::communicator &comm, const std::string &name, std::vector<T> data,
+        Compare cmp);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    try {
+        mpi::environment env;
+        mpi::communicator comm;
+        std::mt19937 engine(3);
+        int N = 50000;
+
+        std::vector<double> uniform(N), dup(N);
+        std::vector<std::string> words(N / 10);
+
+        for (auto &x : uniform)
+            x = std::uniform_real_distribution<double>(-1.0, 1.0)(engine);
+        for (auto &x : dup)
+            x = (engine() % 10) ? 1.0 : engine() % 100;
+        for (auto &x : words)
+            x = std::to_string(engine() % 1000);
+
+        test_select(comm, "uniform", uniform, std::less<double>());
+        test_select(comm, "duplicates", dup, std::greater<double>());
+        test_select(comm, "string", words, std::less<std::string>());
+    } catch (std::exception &e) {
+        std::cout << "Exception caught: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cout << "Unknown exception caught in main()" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+template <typename T, class Compare>
+void test_select(const mpi::communicator &comm, const std::string &name, std::vector<T> data,
+        Compare cmp)
+{
+    int n = data.size();
+    psrs::mpi_vector<T> v(comm, data.begin(), data.end(), 0);
+    std::vector<T> sorted(data);
+
+    std::sort(sorted.begin(), sorted.end(), cmp);
+
+    // Test nth_element at both ends and in the middle
+    for (long long k : {0, n / 3, n / 2, n - 1}) {
+        T kth = psrs::nth_element(v, k, cmp);
+        if (cmp(kth, sorted[k]) || cmp(sorted[k], kth))
+            throw std::runtime_error("Error: nth_element() in test_select() " + name +
+                    ".\nWrong element for k = " + std::to_string(k) + " on proc " +
+                    std::to_string(comm.rank()) + '.');
+    } // Loop over ranks
+
+    // Test partial_sort
+    for (long long k : {1, 100, n / 2, n + 5}) {
+        std::vector<T> top = psrs::partial_sort(v, k, cmp);
+        long long expected = std::min<long long>(k, n);
+
+        if (static_cast<long long>(top.size()) != expected ||
+                !std::equal(top.begin(), top.end(), sorted.begin()))
+            throw std::runtime_error("Error: partial_sort() in test_select() " + name +
+                    ".\nWrong result for k = " + std::to_string(k) + " on proc " +
+                    std::to_string(comm.rank()) + '.');
+    } // Loop over k
+
+    // Test quantiles
+    std::vector<double> q = {0.0, 0.25, 0.5, 0.99, 1.0};
+    std::vector<T> quant = psrs::quantiles(v, q, cmp);
+
+    for (std::size_t i = 0; i < q.size(); i++) {
+        const T &expected = sorted[static_cast<long long>(q[i] * (n - 1))];
+        if (cmp(quant[i], expected) || cmp(expected, quant[i]))
+            throw std::runtime_error("Error: quantiles() in test_select() " + name +
+                    ".\nWrong element for q = " + std::to_string(q[i]) + " on proc " +
+                    std::to_string(comm.rank()) + '.');
+    } // Loop over quantiles
+
+    // Local data is only reordered
+    v.gather(0);
+    if (!comm.rank()) {
+        std::sort(v.begin(), v.end(), cmp);
+        if (!std::equal(v.begin(), v.end(), sorted.begin(), sorted.end()))
+            throw std::runtime_error("Error: test_select() " + name +
+                    ".\nExpected data to be a permutation of the input.");
+    }
+}
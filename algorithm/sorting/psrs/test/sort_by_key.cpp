@@ -0,0 +1,166 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/sort.h"
+#include "../psrs/sort_by_key.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_sort_by_key(const mpi::communicator &comm, psrs::partition_mode mode);
+void test_stable_sort(const mpi::communicator &comm);
+void test_signed_zero(const mpi::communicator &comm);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    try {
+        mpi::environment env;
+        mpi::communicator comm;
+
+        test_sort_by_key(comm, psrs::partition_mode::regular_sampling);
+        test_sort_by_key(comm, psrs::partition_mode::histogram);
+        test_stable_sort(comm);
+        test_signed_zero(comm);
+    } catch (std::exception &e) {
+        std::cout << "Exception caught: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cout << "Unknown exception caught in main()" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_sort_by_key(const mpi::communicator &comm, psrs::partition_mode mode)
+{
+    int N = 10000;
+    std::vector<int> keys(N);
+    std::vector<std::string> values(N);
+    std::mt19937 engine(7);
+
+    // Few distinct keys, so stability matters. Each payload records its original position.
+    for (int i = 0; i < N; i++) {
+        keys[i] = engine() % 16;
+        values[i] = std::to_string(keys[i]) + ':' + std::to_string(i);
+    }
+
+    psrs::mpi_vector<int> k(comm, keys.begin(), keys.end(), 0);
+    psrs::mpi_vector<std::string> v(comm, values.begin(), values.end(), 0);
+    psrs::sort_options opts;
+    opts.partition = mode;
+
+    psrs::sort_by_key(k, v, std::less<int>(), opts);
+
+    // Every payload has to stay with its key
+    for (std::size_t i = 0; i < k.size(); i++)
+        if (v[i].substr(0, v[i].find(':')) != std::to_string(k[i]))
+            throw std::runtime_error("Error: sort_by_key() in test_sort_by_key().\n"
+                    "Expected value to follow its key on proc " + std::to_string(comm.rank()) + '.');
+
+    k.gather(0);
+    v.gather(0);
+
+    if (comm.rank())
+        return;
+
+    // Expected order is a stable sort of the original records
+    std::vector<int> order(N);
+    for (int i = 0; i < N; i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&keys](int a, int b) {
+        return keys[a] < keys[b];
+    });
+
+    for (int i = 0; i < N; i++)
+        if (k[i] != keys[order[i]] || v[i] != values[order[i]])
+            throw std::runtime_error("Error: sort_by_key() in test_sort_by_key().\n"
+                    "Expected a stable sort by key on proc 0 at index " + std::to_string(i) + '.');
+}
+
+
+void test_stable_sort(const mpi::communicator &comm)
+{
+    int N = 10000;
+    std::vector<std::string> data(N);
+    std::mt19937 engine(11);
+
+    // Only the first character is compared, the rest records the original position
+    for (int i = 0; i < N; i++)
+        data[i] = std::string(1, 'a' + engine() % 8) + std::to_string(i);
+
+    auto first_char = [](const std::string &lhs, const std::string &rhs) {
+        return lhs[0] < rhs[0];
+    };
+
+    psrs::mpi_vector<std::string> v(comm, data.begin(), data.end(), 0);
+
+    psrs::stable_sort(v, first_char);
+    v.gather(0);
+
+    if (comm.rank())
+        return;
+
+    std::stable_sort(data.begin(), data.end(), first_char);
+
+    if (!std::equal(data.begin(), data.end(), v.begin(), v.end()))
+        throw std::runtime_error("Error: stable_sort() in test_stable_sort().\n"
+                "Expected equal elements to keep their order on proc 0.");
+}
+
+
+void test_signed_zero(const mpi::communicator &comm)
+{
+    int N = 10000;
+    std::vector<double> keys(N);
+    std::vector<int> values(N);
+    std::mt19937 engine(13);
+
+    // -0.0 and 0.0 compare equal, so they have to keep their original order
+    for (int i = 0; i < N; i++) {
+        keys[i] = engine() % 2 ? -0.0 : 0.0;
+        if (engine() % 4 == 0)
+            keys[i] = engine() % 2 ? -1.0 : 1.0;
+        values[i] = i;
+    }
+
+    psrs::mpi_vector<double> k(comm, keys.begin(), keys.end(), 0);
+    psrs::mpi_vector<int> v(comm, values.begin(), values.end(), 0);
+
+    psrs::sort_by_key(k, v);
+    k.gather(0);
+    v.gather(0);
+
+    if (comm.rank())
+        return;
+
+    std::vector<int> order(values);
+    std::stable_sort(order.begin(), order.end(), [&keys](int a, int b) {
+        return keys[a] < keys[b];
+    });
+
+    for (int i = 0; i < N; i++)
+        if (v[i] != order[i] || std::signbit(k[i]) != std::signbit(keys[order[i]]))
+            throw std::runtime_error("Error: sort_by_key() in test_signed_zero().\n"
+                    "Expected signed zeros to keep their order on proc 0 at index " +
+                    std::to_string(i) + '.');
+}
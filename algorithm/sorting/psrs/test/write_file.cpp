@@ -0,0 +1,99 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <cstdio>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+
+#include "../psrs/mpi_vector.h"
+#include "../psrs/mpi_utility.h"
+
+
+namespace mpi = boost::mpi;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_int(const mpi::communicator &comm, const std::string &path);
+void test_string(const mpi::communicator &comm, const std::string &path);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    try {
+        mpi::environment env;
+        mpi::communicator comm;
+        std::string path = "write_file_test.txt";
+
+        test_int(comm, path);
+        test_string(comm, path);
+
+        comm.barrier();
+        if (!comm.rank())
+            std::remove(path.c_str());
+    } catch (std::exception &e) {
+        std::cout << "Exception caught: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cout << "Unknown exception caught in main()" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+void test_int(const mpi::communicator &comm, const std::string &path)
+{
+    int N = 1000;
+    int p = comm.size();
+    int id = comm.rank();
+    std::vector<int> data(N);
+
+    std::iota(data.begin(), data.end(), -N / 2);
+
+    // Uneven pieces, so the formatted slices have different lengths
+    int low = (id * id) * N / (p * p);
+    int high = ((id + 1) * (id + 1)) * N / (p * p);
+    psrs::mpi_vector<int> v(comm);
+    v.assign(data.begin() + low, data.begin() + high);
+
+    v.write_file(path);
+
+    psrs::mpi_vector<int> w(comm);
+    w.read_file(path);
+    w.gather(0);
+
+    if (!id && !std::equal(data.begin(), data.end(), w.begin(), w.end()))
+        throw std::runtime_error("Error: write_file() in test_int().\n"
+                "Expected data read back to be equal on proc 0.");
+}
+
+
+void test_string(const mpi::communicator &comm, const std::string &path)
+{
+    std::vector<std::string> data = {"alpha", "b", "charlie", "delta", "echo", "foxtrot", "g",
+        "hotel", "india", "juliett", "kilo", "lima", "mike"};
+
+    psrs::mpi_vector<std::string> v(comm);
+    v.distribute(data.begin(), data.end(), 0);
+
+    v.write_file(path, "\n");
+
+    psrs::mpi_vector<std::string> w(comm);
+    w.read_file(path);
+    w.gather(0);
+
+    if (!comm.rank() && !std::equal(data.begin(), data.end(), w.begin(), w.end()))
+        throw std::runtime_error("Error: write_file() in test_string().\n"
+                "Expected data read back to be equal on proc 0.");
+}